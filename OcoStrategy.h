@@ -12,8 +12,8 @@
 #include "borsa/borsa.h"
 
 class OcoStrategy final {
-	const ba::ParamType upper_sell_percentage;
-	const ba::ParamType lower_sell_percentage;
+	ba::ParamType upper_sell_percentage;
+	ba::ParamType lower_sell_percentage;
 	//ba::Money longed_at{ 0 };
 	ba::MoneyType upper_sell_level{ 0 };
 	ba::MoneyType lower_sell_level{ 0 };
@@ -48,7 +48,7 @@ public:
 		switch (positionType) {
 			case ba::PositionType::Closed:
 				
-				if ((rand() & 0x1) == 0) {
+				if (e.randomService.NextBool()) {
 
 					upper_sell_level = e.bid * upper_sell_percentage;
 					lower_sell_level = e.bid * lower_sell_percentage;
@@ -71,6 +71,11 @@ public:
 		
 		e.orderService.ClosePosition();
 	}
+	
+	template<typename Archive>
+	void Serialize(Archive& archive) {
+		archive(upper_sell_percentage, lower_sell_percentage, upper_sell_level, lower_sell_level);
+	}
 };
 
 #endif /* OcoStrategy_h */
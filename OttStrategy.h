@@ -14,8 +14,8 @@
 class OttStrategy final {
 	
 private:
-	const ba::ParamType stoploss_percentage_to_buy;
-	const ba::ParamType stoploss_percentage_to_sell;
+	ba::ParamType stoploss_percentage_to_buy;
+	ba::ParamType stoploss_percentage_to_sell;
 	ba::MoneyType furthest_bid{};
 	ba::MoneyType stoploss_value{};
 	
@@ -60,6 +60,11 @@ public:
 		e.orderService.ClosePosition();
 	}
 	
+	template<typename Archive>
+	void Serialize(Archive& archive) {
+		archive(stoploss_percentage_to_buy, stoploss_percentage_to_sell, furthest_bid, stoploss_value);
+	}
+	
 private:
 	
 	void AppyRulesForClosedPosition(ba::BarClosedEvent& e) noexcept {
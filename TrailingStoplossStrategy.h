@@ -13,10 +13,17 @@
 class TrailingStoplossStrategy final {
 	
 private:
-	const ba::ParamType stoploss_percentage_to_buy;
-	const ba::ParamType stoploss_percentage_to_sell;
+	ba::ParamType stoploss_percentage_to_buy;
+	ba::ParamType stoploss_percentage_to_sell;
 	ba::MoneyType furthest_bid{};
 	ba::MoneyType stoploss_value{};
+	ba::MoneyType stoploss_reference{};
+	
+	// stoploss percentages strictly between these bounds take every decision of the run the same way
+	ba::ParamType buy_factor_low{ 0 };
+	ba::ParamType buy_factor_high{ std::numeric_limits<ba::ParamType>::infinity() };
+	ba::ParamType sell_factor_low{ 0 };
+	ba::ParamType sell_factor_high{ std::numeric_limits<ba::ParamType>::infinity() };
 	
 public:
 
@@ -33,11 +40,20 @@ public:
 	std::vector<ba::ParamType> params() const noexcept {
 		return std::vector{stoploss_percentage_to_buy * 100 - 100, 100 - stoploss_percentage_to_sell * 100};
 	}
+	
+	// every decision compares a bid with a reference bid times one of the percentages,
+	// so the ratios met on the way bound the params that would have decided alike
+	std::vector<std::pair<ba::ParamType, ba::ParamType>> DecisionRegion() const noexcept {
+		return {
+			{ buy_factor_low * 100 - 100, buy_factor_high * 100 - 100 },
+			{ 100 - sell_factor_high * 100, 100 - sell_factor_low * 100 }
+		};
+	}
 
 	void OnStart(ba::StartEvent& e) noexcept {
 		
 		this->furthest_bid = e.bid;
-		this->stoploss_value = e.bid * this->stoploss_percentage_to_buy;
+		this->SetStoploss(e.bid, this->stoploss_percentage_to_buy);
 	}
 
 	void OnBarClosed(ba::BarClosedEvent& e) noexcept {
@@ -57,20 +73,47 @@ public:
 	void OnStop(ba::StopEvent& e) noexcept {
 	}
 	
+	template<typename Archive>
+	void Serialize(Archive& archive) {
+		archive(stoploss_percentage_to_buy, stoploss_percentage_to_sell, furthest_bid, stoploss_value, stoploss_reference, buy_factor_low, buy_factor_high, sell_factor_low, sell_factor_high);
+	}
+	
 private:
 	
+	void SetStoploss(const ba::MoneyType reference, const ba::ParamType percentage) noexcept {
+		this->stoploss_reference = reference;
+		this->stoploss_value = reference * percentage;
+	}
+	
+	// the bid was compared with stoploss_reference * factor, a factor below bid / stoploss_reference gives is_above
+	void Bound(const ba::MoneyType bid, const bool is_above, ba::ParamType& low, ba::ParamType& high) const noexcept {
+		if (this->stoploss_reference <= 0) {
+			return;
+		}
+		const ba::ParamType ratio = bid / this->stoploss_reference;
+		if (is_above) {
+			high = std::min(high, ratio);
+		}
+		else {
+			low = std::max(low, ratio);
+		}
+	}
+	
 	void AppyRulesForClosedPosition(ba::BarClosedEvent& e) noexcept {
 		
 		ba::OrderService& orderService = e.orderService;
 		
 		if (e.bid < this->furthest_bid) {
 			this->furthest_bid = e.bid;
-			this->stoploss_value = e.bid * this->stoploss_percentage_to_buy;
+			this->SetStoploss(e.bid, this->stoploss_percentage_to_buy);
 		}
 		
-		if (e.bid > this->stoploss_value) {
+		const bool is_above = e.bid > this->stoploss_value;
+		Bound(e.bid, is_above, this->buy_factor_low, this->buy_factor_high);
+		
+		if (is_above) {
 			this->furthest_bid = e.bid;
-			this->stoploss_value = e.bid * this->stoploss_percentage_to_sell;
+			this->SetStoploss(e.bid, this->stoploss_percentage_to_sell);
 			orderService.OpenPosition();
 		}
 	}
@@ -81,12 +124,15 @@ private:
 		
 		if (e.bid > this->furthest_bid) {
 			this->furthest_bid = e.bid;
-			this->stoploss_value = e.bid * this->stoploss_percentage_to_sell;
+			this->SetStoploss(e.bid, this->stoploss_percentage_to_sell);
 		}
 		
-		if (e.bid < this->stoploss_value) {
+		const bool is_below = e.bid < this->stoploss_value;
+		Bound(e.bid, !is_below, this->sell_factor_low, this->sell_factor_high);
+		
+		if (is_below) {
 			this->furthest_bid = e.bid;
-			this->stoploss_value = e.bid * this->stoploss_percentage_to_buy;
+			this->SetStoploss(e.bid, this->stoploss_percentage_to_buy);
 			orderService.ClosePosition();
 		}
 	}
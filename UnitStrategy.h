@@ -35,6 +35,9 @@ public:
 		
 		e.orderService.ClosePosition();
 	}
+	
+	template<typename Archive>
+	void Serialize(Archive&) { }
 };
 
 #endif /* UnitStrategy_h */
@@ -0,0 +1,552 @@
+//
+//  batch.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef batch_h
+#define batch_h
+
+#include "types.h"
+#include "utils.h"
+#include "writer.h"
+#include "checkpoint.h"
+#include "cache.h"
+#include "tester.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace ba {
+
+	struct BatchJob
+	{
+		std::string                         name;
+		std::string                         strategy;
+		std::vector<std::string>            tickers;
+		std::string                         firstDate;
+		std::string                         lastDate;
+		std::string                         interval{ "1d" };
+		std::vector<std::vector<ParamType>> paramRanges;     // values of every strategy param, swept as RangeUtils::Permutations
+		MoneyType                           balance{ 10'000 };
+		CommissionRateType                  commissionRate{ 0.15 };
+		int                                 priority{ 0 };   // higher runs first, equal priorities run in file order
+		std::string                         outputFileName;  // empty for no output file
+	};
+
+	// Jobs in an ini-like file, '#' starts a comment:
+	//
+	//   [nightly-trailing]
+	//   strategy   = TrailingStoploss
+	//   tickers    = ARCLK.IS, YKBNK.IS, FROTO.IS
+	//   from       = 2020-01-01
+	//   to         = 2023-01-01
+	//   interval   = 1d
+	//   param      = 0.1 : 10 : 0.1      # begin : end : step with a positive step, one line per strategy param
+	//   param      = 3                   # or a single value for a fixed param
+	//   balance    = 10000
+	//   commission = 0.15
+	//   priority   = 1
+	//   output     = nightly-trailing.csv
+	struct BatchJobFile
+	{
+		static std::vector<BatchJob> Read(const std::string& fileName) {
+			std::ifstream file(fileName);
+			if (!file) {
+				throw std::runtime_error("could not open " + fileName);
+			}
+			return Parse(file);
+		}
+
+		static std::vector<BatchJob> Parse(std::istream& in) {
+
+			std::vector<BatchJob> jobs;
+			std::string line;
+			size_t line_no = 0;
+
+			const auto fail = [&](const std::string& message) {
+				throw std::invalid_argument("job file line " + std::to_string(line_no) + ": " + message);
+			};
+
+			const auto number = [&](const std::string& text) {
+				try {
+					size_t used = 0;
+					const double value = std::stod(text, &used);
+					if (used != text.size()) {
+						fail("not a number: " + text);
+					}
+					return value;
+				}
+				catch (const std::logic_error&) {
+					fail("not a number: " + text);
+				}
+				return 0.0;
+			};
+
+			while (std::getline(in, line)) {
+
+				line_no++;
+				line = Trim(line.substr(0, line.find('#')));
+				if (line.empty()) {
+					continue;
+				}
+
+				if (line.front() == '[') {
+					if (line.back() != ']') {
+						fail("job name is not closed");
+					}
+					BatchJob job;
+					job.name = Trim(line.substr(1, line.size() - 2));
+					jobs.push_back(std::move(job));
+					continue;
+				}
+
+				const size_t equals = line.find('=');
+				if (equals == std::string::npos) {
+					fail("expected key = value");
+				}
+				if (jobs.empty()) {
+					fail("value before the first [job]");
+				}
+
+				BatchJob& job = jobs.back();
+				const std::string key = Trim(line.substr(0, equals));
+				const std::string value = Trim(line.substr(equals + 1));
+
+				if (key == "strategy")        { job.strategy = value; }
+				else if (key == "from")       { job.firstDate = value; }
+				else if (key == "to")         { job.lastDate = value; }
+				else if (key == "interval")   { job.interval = value; }
+				else if (key == "balance")    { job.balance = number(value); }
+				else if (key == "commission") { job.commissionRate = number(value); }
+				else if (key == "priority")   { job.priority = static_cast<int>(number(value)); }
+				else if (key == "output")     { job.outputFileName = value; }
+				else if (key == "tickers") {
+					for (const std::string& ticker : StringUtils::Split(value + ',', ',')) {
+						if (!Trim(ticker).empty()) {
+							job.tickers.push_back(Trim(ticker));
+						}
+					}
+				}
+				else if (key == "param") {
+					const std::vector<std::string> parts = StringUtils::Split(value + ':', ':');
+					if (parts.size() == 1) {
+						job.paramRanges.push_back({ number(Trim(parts[0])) });
+						continue;
+					}
+					if (parts.size() != 3) {
+						fail("param is begin : end : step or a single value");
+					}
+					const ParamType begin = number(Trim(parts[0]));
+					const ParamType end = number(Trim(parts[1]));
+					const ParamType step = number(Trim(parts[2]));
+					if (!(step > 0) || !(begin <= end)) {
+						fail("param needs begin <= end and a positive step");
+					}
+					job.paramRanges.push_back(begin == end ? std::vector<ParamType>{ begin } : RangeUtils::Range<ParamType>(begin, end, step));
+				}
+				else {
+					fail("unknown key " + key);
+				}
+			}
+
+			for (const BatchJob& job : jobs) {
+				if (job.strategy.empty() || job.tickers.empty() || job.paramRanges.empty()) {
+					throw std::invalid_argument("job " + job.name + " needs a strategy, tickers and params");
+				}
+			}
+			return jobs;
+		}
+
+	private:
+
+		static std::string Trim(const std::string& text) {
+			const size_t first = text.find_first_not_of(" \t\r");
+			const size_t last = text.find_last_not_of(" \t\r");
+			return first == std::string::npos ? std::string{} : text.substr(first, last - first + 1);
+		}
+	};
+
+	struct BatchOptions
+	{
+		size_t      threadCount{ 0 };         // 0 for one per hardware thread
+		size_t      unitSize{ 256 };          // permutations of one ticker per work unit
+		std::string checkpointFileName;       // empty for no checkpoint
+	};
+
+	struct JobReport
+	{
+		std::string              name;
+		bool                     failed{ false };
+		std::string              error;
+		size_t                   unitCount{ 0 };
+		size_t                   resumedUnitCount{ 0 }; // read from the checkpoint instead of run
+		std::uint64_t            runCount{ 0 };         // tests simulated by this run
+		std::uint64_t            barCount{ 0 };         // bars simulated by this run
+		std::chrono::nanoseconds busy{ 0 };             // worker time spent on the job's units
+		std::chrono::nanoseconds wallTime{ 0 };         // first unit started -> last unit finished
+
+		double RunsPerSecond() const noexcept {
+			return wallTime.count() > 0 ? runCount / (wallTime.count() * 1e-9) : 0;
+		}
+
+		double BarsPerSecond() const noexcept {
+			return wallTime.count() > 0 ? barCount / (wallTime.count() * 1e-9) : 0;
+		}
+	};
+
+	// Runs the jobs of a job file over one worker pool. A work unit is up to unitSize permutations on one ticker;
+	// units are taken in priority order, so a higher priority job finishes before a lower one takes workers.
+	// Every finished unit is appended to the checkpoint, a rerun with the same jobs skips the units found there,
+	// so an interrupted batch resumes where it stopped. A job whose bars fail to load is reported as failed
+	// and the others go on. When every unit of a job is done its output file gets a row per permutation:
+	// params | mean gain | gain on every ticker, gains being final balance / balance.
+	class BatchRunner final
+	{
+	public:
+		// called as loader(ticker, firstDate, lastDate, interval), once per distinct series of the batch
+		using Loader = std::function<std::vector<Bar>(const std::string&, const std::string&, const std::string&, const std::string&)>;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+		using Series = std::shared_ptr<const std::vector<Bar>>;
+		using Sweep = std::function<std::vector<TestSummary>(const std::vector<std::vector<ParamType>>&, const std::vector<Bar>&, MoneyType, CommissionRateType)>;
+
+		static constexpr char          MAGIC[4]{ 'B', 'A', 'B', 'J' };
+		static constexpr std::uint32_t VERSION{ 1 };
+
+		struct Unit
+		{
+			size_t jobNo;
+			size_t unitNo;
+			size_t tickerNo;
+			size_t first;
+			size_t last;
+		};
+
+		struct JobState
+		{
+			const BatchJob*                     job;
+			ResultKey                           key;
+			std::vector<std::vector<ParamType>> permutations;
+			std::vector<CachedResult>           results;      // [ticker no * permutation count + permutation no]
+			std::vector<bool>                   doneUnits;
+			size_t                              remainingUnitCount{ 0 };
+			std::atomic<bool>                   failed{ false };
+			JobReport                           report;
+			Clock::time_point                   startedAt{ Clock::time_point::max() };
+			Clock::time_point                   finishedAt{ Clock::time_point::min() };
+		};
+
+		std::map<std::string, Sweep> sweeps;
+		Loader                       loader;
+
+	public:
+
+		explicit BatchRunner(Loader loader = DefaultLoader) : loader(std::move(loader)) { }
+
+		template <typename StrategyType>
+		void Register(const std::string& strategyName) {
+			sweeps[strategyName] = [](const std::vector<std::vector<ParamType>>& permutations, const std::vector<Bar>& bars, const MoneyType balance, const CommissionRateType commissionRate) {
+				return Tester::RunTestUsingParamPermutations<StrategyType>(permutations, bars, balance, commissionRate, { .recordingMode = RecordingMode::MetricsOnly });
+			};
+		}
+
+		std::vector<JobReport> Run(const std::vector<BatchJob>& jobs, const BatchOptions& options = {}) {
+
+			const size_t unit_size = std::max<size_t>(1, options.unitSize);
+
+			std::vector<std::unique_ptr<JobState>> states;
+			std::vector<Unit> units;
+
+			for (const BatchJob& job : jobs) {
+				if (sweeps.find(job.strategy) == sweeps.end()) {
+					throw std::invalid_argument("job " + job.name + " uses unregistered strategy " + job.strategy);
+				}
+
+				auto state = std::make_unique<JobState>();
+				state->job = &job;
+				state->permutations = RangeUtils::Permutations(job.paramRanges);
+				state->key = JobKey(job, state->permutations, unit_size);
+				state->results.resize(job.tickers.size() * state->permutations.size());
+				state->report.name = job.name;
+
+				const size_t job_no = states.size();
+				size_t unit_no = 0;
+				for (size_t ticker_no = 0; ticker_no < job.tickers.size(); ++ticker_no) {
+					for (size_t first = 0; first < state->permutations.size(); first += unit_size) {
+						units.push_back(Unit{ job_no, unit_no++, ticker_no, first, std::min(state->permutations.size(), first + unit_size) });
+					}
+				}
+				state->doneUnits.assign(unit_no, false);
+				state->remainingUnitCount = unit_no;
+				state->report.unitCount = unit_no;
+				states.push_back(std::move(state));
+			}
+
+			std::unique_ptr<std::ofstream> checkpoint;
+			if (!options.checkpointFileName.empty()) {
+				Resume(options.checkpointFileName, states, units);
+				checkpoint = OpenCheckpoint(options.checkpointFileName);
+			}
+
+			std::erase_if(units, [&](const Unit& unit) { return states[unit.jobNo]->doneUnits[unit.unitNo]; });
+			std::stable_sort(units.begin(), units.end(), [&](const Unit& a, const Unit& b) {
+				return states[a.jobNo]->job->priority > states[b.jobNo]->job->priority;
+			});
+
+			for (auto& state : states) {
+				if (state->remainingUnitCount == 0) {
+					WriteOutput(*state);
+				}
+			}
+
+			std::mutex mutex;
+			std::map<std::string, std::shared_future<Series>> loads;
+
+			const auto load = [&](const BatchJob& job, const std::string& ticker) {
+				const std::string key = ticker + '\n' + job.firstDate + '\n' + job.lastDate + '\n' + job.interval;
+				std::promise<Series> promise;
+				std::shared_future<Series> series;
+				bool loading = false;
+				{
+					std::lock_guard lock(mutex);
+					const auto found = loads.find(key);
+					loading = found == loads.end();
+					series = loading ? loads.emplace(key, promise.get_future().share()).first->second : found->second;
+				}
+				// waited for without the lock, a slow download holds up only the units that need its series
+				if (loading) {
+					try {
+						promise.set_value(std::make_shared<const std::vector<Bar>>(loader(ticker, job.firstDate, job.lastDate, job.interval)));
+					}
+					catch (...) {
+						promise.set_exception(std::current_exception());
+					}
+				}
+				return series.get();
+			};
+
+			ParallelUtils::ForEachIndex(units.size(), options.threadCount, [&](const size_t index) {
+
+				const Unit& unit = units[index];
+				JobState& state = *states[unit.jobNo];
+				if (state.failed) {
+					return;
+				}
+
+				const auto started_at = Clock::now();
+				std::vector<CachedResult> results;
+				std::uint64_t bar_count = 0;
+
+				try {
+					const Series bars = load(*state.job, state.job->tickers[unit.tickerNo]);
+					const std::vector<std::vector<ParamType>> chunk(state.permutations.begin() + unit.first, state.permutations.begin() + unit.last);
+					for (const TestSummary& summary : sweeps.at(state.job->strategy)(chunk, *bars, state.job->balance, state.job->commissionRate)) {
+						results.push_back(CachedResult{ summary.totalOrders, summary.finalBalance, summary.metrics });
+					}
+					bar_count = bars->size() * chunk.size();
+				}
+				catch (const std::exception& e) {
+					std::lock_guard lock(mutex);
+					if (!state.failed.exchange(true)) {
+						state.report.failed = true;
+						state.report.error = e.what();
+					}
+					return;
+				}
+				const auto finished_at = Clock::now();
+
+				std::unique_lock lock(mutex);
+
+				std::copy(results.begin(), results.end(), state.results.begin() + unit.tickerNo * state.permutations.size() + unit.first);
+				state.doneUnits[unit.unitNo] = true;
+				state.report.runCount += results.size();
+				state.report.barCount += bar_count;
+				state.report.busy += finished_at - started_at;
+				state.startedAt = std::min(state.startedAt, started_at);
+				state.finishedAt = std::max(state.finishedAt, finished_at);
+
+				if (checkpoint) {
+					CheckpointWriter writer(*checkpoint);
+					writer(state.key, static_cast<std::uint64_t>(unit.unitNo), results);
+					checkpoint->flush();
+				}
+
+				// the last unit of a job writes its output unlocked, no other unit touches the job's results any more
+				if (--state.remainingUnitCount == 0) {
+					lock.unlock();
+					WriteOutput(state);
+				}
+			});
+
+			std::vector<JobReport> reports;
+			for (auto& state : states) {
+				if (state->report.runCount != 0) {
+					state->report.wallTime = state->finishedAt - state->startedAt;
+				}
+				reports.push_back(std::move(state->report));
+			}
+			return reports;
+		}
+
+	private:
+
+		static std::vector<Bar> DefaultLoader(const std::string& ticker, const std::string& firstDate, const std::string& lastDate, const std::string& interval) {
+			return DataUtils::GetBars(ticker, firstDate, lastDate, interval);
+		}
+
+		// everything that decides the results of a job's units, a changed job starts over
+		static ResultKey JobKey(const BatchJob& job, const std::vector<std::vector<ParamType>>& permutations, const size_t unitSize) {
+			Hasher hasher;
+			hasher.Add(job.name).Add(job.strategy).Add(job.firstDate).Add(job.lastDate).Add(job.interval);
+			hasher.Add(job.balance).Add(job.commissionRate).Add(static_cast<std::uint64_t>(unitSize));
+			hasher.Add(static_cast<std::uint64_t>(job.tickers.size()));
+			for (const std::string& ticker : job.tickers) {
+				hasher.Add(ticker);
+			}
+			hasher.Add(static_cast<std::uint64_t>(permutations.size()));
+			for (const auto& params : permutations) {
+				hasher.Add(params);
+			}
+			return hasher.Key();
+		}
+
+		// reads the units finished by earlier runs, a torn last record is cut off
+		static void Resume(const std::string& fileName, std::vector<std::unique_ptr<JobState>>& states, const std::vector<Unit>& units) {
+
+			std::ifstream file(fileName, std::ios::binary);
+			if (!file) {
+				return;
+			}
+
+			char magic[4] = {0};
+			std::uint32_t version = 0;
+			file.read(magic, sizeof(magic));
+			file.read(reinterpret_cast<char*>(&version), sizeof(version));
+			if (!file || !std::equal(std::begin(magic), std::end(magic), std::begin(MAGIC)) || version != VERSION) {
+				throw std::runtime_error(fileName + " is not a batch checkpoint");
+			}
+
+			std::map<std::pair<std::uint64_t, std::uint64_t>, JobState*> jobs_by_key;
+			for (auto& state : states) {
+				jobs_by_key[{ state->key.high, state->key.low }] = state.get();
+			}
+
+			std::map<std::pair<size_t, size_t>, const Unit*> units_by_no;
+			for (const Unit& unit : units) {
+				units_by_no[{ unit.jobNo, unit.unitNo }] = &unit;
+			}
+			std::map<const JobState*, size_t> job_nos;
+			for (size_t job_no = 0; job_no < states.size(); ++job_no) {
+				job_nos[states[job_no].get()] = job_no;
+			}
+
+			CheckpointReader reader(file);
+			std::streamoff good_size = file.tellg();
+
+			while (file.peek() != std::char_traits<char>::eof()) {
+
+				ResultKey key;
+				std::uint64_t unit_no = 0;
+				std::vector<CachedResult> results;
+				try {
+					reader(key, unit_no, results);
+				}
+				catch (const std::exception&) {
+					break;
+				}
+				good_size = file.tellg();
+
+				const auto state = jobs_by_key.find({ key.high, key.low });
+				if (state == jobs_by_key.end()) {
+					continue;
+				}
+				const auto unit = units_by_no.find({ job_nos[state->second], unit_no });
+				if (unit == units_by_no.end() || results.size() != unit->second->last - unit->second->first) {
+					continue;
+				}
+
+				JobState& job_state = *state->second;
+				if (!job_state.doneUnits[unit_no]) {
+					job_state.doneUnits[unit_no] = true;
+					job_state.remainingUnitCount--;
+					job_state.report.resumedUnitCount++;
+				}
+				std::copy(results.begin(), results.end(), job_state.results.begin() + unit->second->tickerNo * job_state.permutations.size() + unit->second->first);
+			}
+
+			file.close();
+			std::filesystem::resize_file(fileName, static_cast<std::uintmax_t>(good_size));
+		}
+
+		static std::unique_ptr<std::ofstream> OpenCheckpoint(const std::string& fileName) {
+
+			const bool exists = std::filesystem::exists(fileName) && std::filesystem::file_size(fileName) != 0;
+			auto file = std::make_unique<std::ofstream>(fileName, std::ios::binary | std::ios::app);
+			if (!*file) {
+				throw std::runtime_error("could not open " + fileName);
+			}
+			if (!exists) {
+				file->write(MAGIC, sizeof(MAGIC));
+				file->write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+				file->flush();
+			}
+			return file;
+		}
+
+		static void WriteOutput(const JobState& state) {
+
+			const BatchJob& job = *state.job;
+			if (job.outputFileName.empty()) {
+				return;
+			}
+
+			CsvResultWriter writer(job.outputFileName);
+
+			std::vector<std::string> header;
+			for (size_t i = 0; i < job.paramRanges.size(); ++i) {
+				header.push_back("param" + std::to_string(i + 1));
+			}
+			header.push_back("gain");
+			header.insert(header.end(), job.tickers.begin(), job.tickers.end());
+			writer.WriteHeader(header);
+
+			const size_t permutation_count = state.permutations.size();
+			std::vector<double> row;
+			for (size_t permutation_no = 0; permutation_no < permutation_count; ++permutation_no) {
+
+				row = state.permutations[permutation_no];
+				double sum_of_gains = 0;
+				for (size_t ticker_no = 0; ticker_no < job.tickers.size(); ++ticker_no) {
+					sum_of_gains += state.results[ticker_no * permutation_count + permutation_no].finalBalance / job.balance;
+				}
+				row.push_back(sum_of_gains / job.tickers.size());
+				for (size_t ticker_no = 0; ticker_no < job.tickers.size(); ++ticker_no) {
+					row.push_back(state.results[ticker_no * permutation_count + permutation_no].finalBalance / job.balance);
+				}
+				writer.WriteRow(row);
+			}
+		}
+	};
+
+}
+
+#endif /* batch_h */
@@ -10,7 +10,30 @@
 
 #include "types.h"
 #include "enums.h"
+#include "metrics.h"
+#include "random.h"
+#include "compress.h"
 #include "utils.h"
+#include "writer.h"
+#include "checkpoint.h"
+#include "resample.h"
+#include "mapped.h"
+#include "calendar.h"
+#include "prepared.h"
+#include "store.h"
+#include "cache.h"
+#include "rules.h"
+#include "panel.h"
 #include "tester.h"
+#include "montecarlo.h"
+#include "stream.h"
+#include "shard.h"
+#include "pipeline.h"
+#include "daemon.h"
+#include "pareto.h"
+#include "surface.h"
+#include "batch.h"
+#include "budget.h"
+#include "optimizer.h"
 
 #endif /* borsa_h */
@@ -0,0 +1,373 @@
+//
+//  budget.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef budget_h
+#define budget_h
+
+#include "types.h"
+#include "utils.h"
+#include "checkpoint.h"
+#include "resample.h"
+#include "prepared.h"
+#include "tester.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace ba {
+
+	// Bytes a finished TestSummary holds and bytes a run is expected to hold before it starts.
+	struct SweepFootprint
+	{
+		// worst case before any run has finished: an order on every bar
+		static constexpr size_t FULL_BYTES_PER_BAR       = sizeof(MoneyType) + sizeof(OrderLog);
+		static constexpr size_t COMPRESSED_BYTES_PER_BAR = 12;
+
+		static size_t Of(const TestSummary& summary) noexcept {
+
+			size_t bytes = sizeof(TestSummary) + summary.params.capacity() * sizeof(ParamType);
+			if (summary.orderLogs) {
+				bytes += summary.orderLogs->capacity() * sizeof(OrderLog);
+			}
+			if (summary.barEndNetWorths) {
+				bytes += summary.barEndNetWorths->capacity() * sizeof(MoneyType);
+			}
+			if (summary.compressedOrderLogs) {
+				bytes += summary.compressedOrderLogs->ByteCount();
+			}
+			if (summary.compressedBarEndNetWorths) {
+				bytes += summary.compressedBarEndNetWorths->ByteCount();
+			}
+			return bytes;
+		}
+
+		static size_t Estimate(const size_t barCount, const size_t paramCount, const RecordingMode recordingMode) noexcept {
+
+			const size_t fixed = sizeof(TestSummary) + paramCount * sizeof(ParamType);
+			switch (recordingMode) {
+				case RecordingMode::Full:        return fixed + barCount * FULL_BYTES_PER_BAR;
+				case RecordingMode::Compressed:  return fixed + barCount * COMPRESSED_BYTES_PER_BAR;
+				case RecordingMode::MetricsOnly: return fixed;
+			}
+			return fixed;
+		}
+	};
+
+	struct BudgetOptions
+	{
+		size_t                memoryBudget{ size_t(1) << 30 }; // bytes for running and finished results together
+		size_t                threadCount{ 0 };
+		std::filesystem::path spillDirectory{ };                // the temporary directory when empty
+	};
+
+	// Summaries of a budgeted sweep in permutation order, each either in memory or in the spill file.
+	// The spill file is removed with the results.
+	class SweepResults final
+	{
+		template<typename> friend class BudgetedSweep;
+
+	private:
+		static constexpr std::uint64_t RESIDENT = std::numeric_limits<std::uint64_t>::max();
+
+		std::vector<std::optional<TestSummary>> summaries;
+		std::vector<std::uint64_t>              offsets;
+		std::filesystem::path                   spillPath;
+		std::ofstream                           spill;
+		size_t                                  spilledCount{ 0 };
+		size_t                                  peakBytes{ 0 };
+
+	public:
+
+		SweepResults() = default;
+		SweepResults(SweepResults&& other) noexcept
+			: summaries(std::move(other.summaries)),
+			  offsets(std::move(other.offsets)),
+			  spillPath(std::exchange(other.spillPath, {})),
+			  spill(std::move(other.spill)),
+			  spilledCount(other.spilledCount),
+			  peakBytes(other.peakBytes) { }
+
+		SweepResults& operator=(SweepResults&&) = delete;
+
+		~SweepResults() {
+			if (!spillPath.empty()) {
+				spill.close();
+				std::error_code error;
+				std::filesystem::remove(spillPath, error);
+			}
+		}
+
+		size_t size() const noexcept { return summaries.size(); }
+		bool empty() const noexcept { return summaries.empty(); }
+
+		bool IsSpilled(const size_t index) const noexcept { return offsets[index] != RESIDENT; }
+		size_t SpilledCount() const noexcept { return spilledCount; }
+
+		// largest number of bytes held by running and finished results at once
+		size_t PeakBytes() const noexcept { return peakBytes; }
+
+		// a spilled summary is read back from disk, every call reads it again
+		TestSummary Get(const size_t index) const {
+			if (!IsSpilled(index)) {
+				return Copy(*summaries[index]);
+			}
+			std::ifstream in(spillPath, std::ios::binary);
+			in.seekg(static_cast<std::streamoff>(offsets[index]));
+			CheckpointReader reader(in);
+			return ReadSummary(reader);
+		}
+
+		// calls fn(index, summary) in permutation order, spilled summaries are read one at a time
+		template<typename Function>
+		void ForEach(Function&& fn) const {
+
+			std::ifstream in;
+			if (spilledCount != 0) {
+				in.open(spillPath, std::ios::binary);
+			}
+			CheckpointReader reader(in);
+
+			for (size_t index = 0; index < summaries.size(); ++index) {
+				if (IsSpilled(index)) {
+					in.seekg(static_cast<std::streamoff>(offsets[index]));
+					const TestSummary summary = ReadSummary(reader);
+					fn(index, summary);
+				}
+				else {
+					fn(index, *summaries[index]);
+				}
+			}
+		}
+
+	private:
+
+		static TestSummary Copy(const TestSummary& summary) {
+			return TestSummary {
+				.totalOrders               = summary.totalOrders,
+				.finalBalance              = summary.finalBalance,
+				.params                    = summary.params,
+				.metrics                   = summary.metrics,
+				.orderLogs                 = summary.orderLogs,
+				.barEndNetWorths           = summary.barEndNetWorths,
+				.compressedOrderLogs       = summary.compressedOrderLogs,
+				.compressedBarEndNetWorths = summary.compressedBarEndNetWorths
+			};
+		}
+	};
+
+	// A param sweep that keeps running and finished results within a memory budget, so the same job runs on
+	// a small machine, only slower and with more of its results on disk.
+	// A run reserves its estimated footprint before it starts and waits while the reservation does not fit.
+	// The first estimate assumes an order on every bar; once runs finish, the largest footprint per bar seen
+	// so far plus a quarter is used instead. Finished results count with their real size, and when they push
+	// the total over the budget all of them are appended to the spill file. The file is written outside the
+	// sweep's lock, results being written still count until they are on disk.
+	// One run is always let in, a single run larger than the budget still finishes.
+	// The series and the strategies' own state are not counted, the series is shared by every run.
+	template<typename StrategyType>
+	class BudgetedSweep final
+	{
+	private:
+		const size_t               barCount;
+		const RecordingMode        recordingMode;
+		const BudgetOptions&       budget;
+		SweepResults&              results;
+
+		std::mutex                 mutex;
+		std::condition_variable    released;
+		size_t                     reservedBytes{ 0 };
+		size_t                     residentBytes{ 0 };   // finished results in memory, not yet being spilled
+		size_t                     spillingBytes{ 0 };   // finished results being written to the spill file
+		size_t                     runningCount{ 0 };
+		double                     bytesPerBar{ 0 };
+		std::vector<size_t>        residentIndices;      // indices of the results residentBytes counts
+
+		std::mutex                 spillMutex;           // one spill writes the file at a time
+
+		BudgetedSweep(const size_t barCount, const RecordingMode recordingMode, const BudgetOptions& budget, SweepResults& results) noexcept
+			: barCount(barCount), recordingMode(recordingMode), budget(budget), results(results) { }
+
+	public:
+
+		// options.runId is replaced by a hash of the params as in Tester::RunTestUsingParamPermutations,
+		// the results are the same as its results
+		// bars is a std::vector<Bar>, a TimeframeSeries or a PreparedSeries shared by every run
+		template<typename SeriesType>
+		static
+		SweepResults Run(const std::vector<std::vector<ParamType>>& paramPermutations,
+						 const SeriesType& bars,
+						 const MoneyType balance,
+						 const CommissionRateType commissionRate,
+						 const TestOptions& options = {},
+						 const BudgetOptions& budget = {})
+		{
+			SweepResults results;
+			results.summaries.resize(paramPermutations.size());
+			results.offsets.assign(paramPermutations.size(), SweepResults::RESIDENT);
+
+			BudgetedSweep sweep(Tester::BaseBars(bars).size(), options.recordingMode, budget, results);
+
+			ParallelUtils::ForEachIndex(paramPermutations.size(), budget.threadCount, [&](const size_t index) {
+
+				const std::vector<ParamType>& params = paramPermutations[index];
+
+				// built before the reservation: a strategy rejecting its params throws without holding any of the budget
+				StrategyType strategy {params};
+
+				TestOptions run_options = options;
+				run_options.runId = Hasher().Add(params).Key().low;
+
+				const size_t reservation = sweep.Reserve(params.size());
+				sweep.Finish(index, reservation, Tester::RunTest(strategy, bars, balance, commissionRate, run_options));
+			});
+
+			if (results.spill.is_open()) {
+				results.spill.close();
+			}
+			return results;
+		}
+
+	private:
+
+		size_t Estimate(const size_t paramCount) const noexcept {
+			if (bytesPerBar == 0 || recordingMode == RecordingMode::MetricsOnly) {
+				return SweepFootprint::Estimate(barCount, paramCount, recordingMode);
+			}
+			return SweepFootprint::Estimate(0, paramCount, recordingMode) + static_cast<size_t>(bytesPerBar * 1.25 * barCount);
+		}
+
+		size_t Reserve(const size_t paramCount) {
+
+			std::unique_lock lock(mutex);
+
+			while (true) {
+				const size_t reservation = Estimate(paramCount);
+				if (HeldBytes() + reservation <= budget.memoryBudget) {
+					return Admit(reservation);
+				}
+				if (residentBytes != 0) {
+					SpillAll(lock);
+					continue;
+				}
+				if (runningCount == 0 && spillingBytes == 0) {
+					return Admit(reservation);
+				}
+				released.wait(lock);
+			}
+		}
+
+		size_t HeldBytes() const noexcept {
+			return reservedBytes + residentBytes + spillingBytes;
+		}
+
+		size_t Admit(const size_t reservation) noexcept {
+			reservedBytes += reservation;
+			runningCount++;
+			results.peakBytes = std::max(results.peakBytes, HeldBytes());
+			return reservation;
+		}
+
+		void Finish(const size_t index, const size_t reservation, TestSummary summary) {
+
+			const size_t bytes = SweepFootprint::Of(summary);
+
+			std::unique_lock lock(mutex);
+
+			reservedBytes -= reservation;
+			runningCount--;
+			residentBytes += bytes;
+			results.peakBytes = std::max(results.peakBytes, HeldBytes());
+
+			const size_t fixed = SweepFootprint::Estimate(0, summary.params.size(), recordingMode);
+			if (barCount != 0 && bytes > fixed) {
+				bytesPerBar = std::max(bytesPerBar, double(bytes - fixed) / barCount);
+			}
+			results.summaries[index].emplace(std::move(summary));
+			residentIndices.push_back(index);
+			released.notify_all();
+
+			if (HeldBytes() > budget.memoryBudget) {
+				SpillAll(lock);
+			}
+		}
+
+		// appends every finished result still in memory to the spill file, called with the mutex held
+		// the results are written with the mutex released, each stays in memory until its offset is set
+		void SpillAll(std::unique_lock<std::mutex>& lock) {
+
+			std::vector<size_t> indices = std::exchange(residentIndices, {});
+			const size_t bytes = std::exchange(residentBytes, 0);
+			spillingBytes += bytes;
+			lock.unlock();
+
+			std::vector<std::uint64_t> offsets;
+			try {
+				offsets.reserve(indices.size());
+				std::lock_guard spill_lock(spillMutex);
+				OpenSpill();
+				CheckpointWriter writer(results.spill);
+				for (const size_t index : indices) {
+					offsets.push_back(static_cast<std::uint64_t>(results.spill.tellp()));
+					WriteSummary(writer, *results.summaries[index]);
+				}
+				results.spill.flush();
+				if (!results.spill) {
+					throw std::runtime_error("spill file could not be written: " + results.spillPath.string());
+				}
+			}
+			catch (...) {
+				lock.lock();
+				spillingBytes -= bytes;
+				residentBytes += bytes;
+				residentIndices.insert(residentIndices.end(), indices.begin(), indices.end());
+				released.notify_all();
+				throw;
+			}
+
+			lock.lock();
+			for (size_t i = 0; i < indices.size(); ++i) {
+				results.offsets[indices[i]] = offsets[i];
+				results.summaries[indices[i]].reset();
+			}
+			results.spilledCount += indices.size();
+			spillingBytes -= bytes;
+			released.notify_all();
+		}
+
+		// called with spillMutex held
+		void OpenSpill() {
+
+			if (results.spill.is_open()) {
+				return;
+			}
+			static std::atomic<size_t> spill_counter{ 0 };
+			const std::filesystem::path directory = budget.spillDirectory.empty() ? std::filesystem::temp_directory_path() : budget.spillDirectory;
+			results.spillPath = directory / ("sweep." + std::to_string(getpid()) + "." + std::to_string(spill_counter++) + ".spill");
+			results.spill.open(results.spillPath, std::ios::binary | std::ios::trunc);
+			if (!results.spill) {
+				throw std::runtime_error("spill file could not be created: " + results.spillPath.string());
+			}
+		}
+	};
+
+}
+
+#endif /* budget_h */
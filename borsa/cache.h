@@ -0,0 +1,419 @@
+//
+//  cache.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef cache_h
+#define cache_h
+
+#include "types.h"
+#include "random.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <shared_mutex>
+#include <mutex>
+#include <string>
+#include <stdexcept>
+#include <typeinfo>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ba {
+
+	struct ResultKey
+	{
+		std::uint64_t high{ 0 };
+		std::uint64_t low{ 0 };
+
+		bool operator==(const ResultKey&) const noexcept = default;
+	};
+
+	// 128 bit hash built from two independently seeded SplitMix64 lanes
+	class Hasher final
+	{
+	private:
+		std::uint64_t high{ 0x243F6A8885A308D3ull };
+		std::uint64_t low{ 0x13198A2E03707344ull };
+
+	public:
+
+		Hasher& Add(const std::uint64_t value) noexcept {
+			high = RandomService::Mix(high ^ value);
+			low  = RandomService::Mix(low + value * 0x9E3779B97F4A7C15ull) ^ high;
+			return *this;
+		}
+
+		Hasher& Add(const double value) noexcept {
+			return Add(std::bit_cast<std::uint64_t>(value));
+		}
+
+		Hasher& Add(const std::string& value) noexcept {
+			Add(static_cast<std::uint64_t>(value.size()));
+			for (size_t i = 0; i < value.size(); i += 8) {
+				std::uint64_t word = 0;
+				std::memcpy(&word, value.data() + i, std::min<size_t>(8, value.size() - i));
+				Add(word);
+			}
+			return *this;
+		}
+
+		Hasher& Add(const std::vector<double>& values) noexcept {
+			Add(static_cast<std::uint64_t>(values.size()));
+			for (const double value : values) {
+				Add(value);
+			}
+			return *this;
+		}
+
+		Hasher& Add(const ResultKey& key) noexcept {
+			return Add(key.high).Add(key.low);
+		}
+
+		ResultKey Key() const noexcept {
+			return ResultKey{ RandomService::Mix(high), RandomService::Mix(low ^ high) };
+		}
+	};
+
+	struct CachedResult
+	{
+		std::uint64_t      totalOrders{ 0 };
+		MoneyType          finalBalance{ 0 };
+		PerformanceMetrics metrics{ };
+	};
+
+	// Persistent cache of test results keyed by the content of everything that decides a run.
+	// Results go to an append-only log (<path>.log), lookups use an open addressing index mapped
+	// from <path>.idx. The index can always be rebuilt from the log, a torn tail of the log is dropped.
+	// One process writes a cache at a time, threads of that process may share it.
+	class ResultCache final
+	{
+	private:
+		struct Record
+		{
+			ResultKey    key;
+			CachedResult result;
+		};
+
+		struct Slot
+		{
+			ResultKey     key;
+			std::uint64_t recordNo{ 0 }; // record number + 1, zero marks an empty slot
+		};
+
+		struct LogHeader
+		{
+			char          magic[4]{ 'B', 'A', 'R', 'L' };
+			std::uint32_t version{ 1 };
+			std::uint32_t recordSize{ sizeof(Record) };
+			std::uint32_t reserved{ 0 };
+		};
+
+		struct IndexHeader
+		{
+			char          magic[4]{ 'B', 'A', 'R', 'I' };
+			std::uint32_t version{ 1 };
+			std::uint64_t capacity{ 0 };
+			std::uint64_t indexedRecordCount{ 0 };
+			std::uint64_t reserved{ 0 };
+		};
+
+		static constexpr std::uint64_t MIN_CAPACITY{ 1024 };
+
+		const std::string logFileName;
+		const std::string indexFileName;
+		int logFd{ -1 };
+		std::uint64_t recordCount{ 0 };
+		void* indexMapping{ nullptr };
+		size_t indexMappingSize{ 0 };
+		mutable std::shared_mutex mutex;
+
+	public:
+
+		explicit ResultCache(const std::string& path)
+		: logFileName(path + ".log")
+		, indexFileName(path + ".idx")
+		{
+			OpenLog();
+			OpenIndex();
+		}
+
+		ResultCache(const ResultCache&) = delete;
+		ResultCache& operator=(const ResultCache&) = delete;
+
+		~ResultCache() {
+			UnmapIndex();
+			if (logFd >= 0) {
+				close(logFd);
+			}
+		}
+
+		size_t size() const noexcept {
+			std::shared_lock lock(mutex);
+			return recordCount;
+		}
+
+		std::optional<CachedResult> Find(const ResultKey& key) const {
+
+			std::shared_lock lock(mutex);
+
+			const std::uint64_t record_no = FindRecordNo(key);
+			if (record_no == 0) {
+				return std::nullopt;
+			}
+			Record record;
+			ReadRecords(record_no - 1, 1, &record);
+			return record.result;
+		}
+
+		void Insert(const ResultKey& key, const CachedResult& result) {
+
+			std::unique_lock lock(mutex);
+
+			if (FindRecordNo(key) != 0) {
+				return;
+			}
+
+			const Record record{ key, result };
+			if (write(logFd, &record, sizeof(Record)) != static_cast<ssize_t>(sizeof(Record))) {
+				throw std::runtime_error("could not append to " + logFileName);
+			}
+			recordCount++;
+
+			if (recordCount * 2 > Header().capacity) {
+				RebuildIndex(Header().capacity * 2);
+			}
+			else {
+				InsertSlot(key, recordCount);
+				Header().indexedRecordCount = recordCount;
+			}
+		}
+
+		// forces the log to disk, the index is recovered from the log if it is lost
+		void Sync() const {
+			std::shared_lock lock(mutex);
+			fsync(logFd);
+		}
+
+		// strategies may define `static constexpr std::uint32_t VERSION` and bump it when their logic changes
+		template <typename StrategyType>
+		static ResultKey MakeKey(const std::vector<ParamType>& params,
+								 const ResultKey& seriesKey,
+								 const MoneyType balance,
+								 const CommissionRateType commissionRate,
+								 const TestOptions& options) noexcept
+		{
+			std::uint64_t version = 0;
+			if constexpr (requires { StrategyType::VERSION; }) {
+				version = StrategyType::VERSION;
+			}
+
+			return Hasher()
+				.Add(std::string(typeid(StrategyType).name()))
+				.Add(version)
+				.Add(params)
+				.Add(seriesKey)
+				.Add(balance)
+				.Add(commissionRate)
+				.Add(options.barsPerYear)
+				.Add(options.seed)
+				.Add(options.runId)
+				.Key();
+		}
+
+		// hash the series once per sweep and reuse it for every cell
+		static ResultKey SeriesKey(const std::vector<Bar>& bars) noexcept {
+
+			Hasher hasher;
+			hasher.Add(static_cast<std::uint64_t>(bars.size()));
+			for (const Bar& bar : bars) {
+				hasher.Add(bar.date).Add(static_cast<std::uint64_t>(bar.time)).Add(bar.open).Add(bar.high).Add(bar.low).Add(bar.close);
+			}
+			return hasher.Key();
+		}
+
+	private:
+
+		IndexHeader& Header() const noexcept {
+			return *static_cast<IndexHeader*>(indexMapping);
+		}
+
+		Slot* Slots() const noexcept {
+			return reinterpret_cast<Slot*>(static_cast<char*>(indexMapping) + sizeof(IndexHeader));
+		}
+
+		std::uint64_t FindRecordNo(const ResultKey& key) const noexcept {
+
+			const std::uint64_t mask = Header().capacity - 1;
+			const Slot* slots = Slots();
+			for (std::uint64_t i = key.low & mask; ; i = (i + 1) & mask) {
+				if (slots[i].recordNo == 0) {
+					return 0;
+				}
+				if (slots[i].key == key) {
+					return slots[i].recordNo;
+				}
+			}
+		}
+
+		static void InsertSlot(Slot* slots, const std::uint64_t capacity, const ResultKey& key, const std::uint64_t recordNo) noexcept {
+			const std::uint64_t mask = capacity - 1;
+			std::uint64_t i = key.low & mask;
+			while (slots[i].recordNo != 0) {
+				i = (i + 1) & mask;
+			}
+			slots[i] = Slot{ key, recordNo };
+		}
+
+		void InsertSlot(const ResultKey& key, const std::uint64_t recordNo) noexcept {
+			InsertSlot(Slots(), Header().capacity, key, recordNo);
+		}
+
+		void ReadRecords(const std::uint64_t firstRecord, const size_t count, Record* records) const {
+			const off_t offset = static_cast<off_t>(sizeof(LogHeader) + firstRecord * sizeof(Record));
+			const ssize_t size = static_cast<ssize_t>(count * sizeof(Record));
+			if (pread(logFd, records, size, offset) != size) {
+				throw std::runtime_error("could not read " + logFileName);
+			}
+		}
+
+		// calls fn(key, recordNo) for records [firstRecord, recordCount)
+		template <typename Function>
+		void ForEachRecord(const std::uint64_t firstRecord, Function&& fn) const {
+			std::vector<Record> chunk(4096);
+			for (std::uint64_t record = firstRecord; record < recordCount; ) {
+				const size_t count = static_cast<size_t>(std::min<std::uint64_t>(chunk.size(), recordCount - record));
+				ReadRecords(record, count, chunk.data());
+				for (size_t i = 0; i < count; ++i) {
+					fn(chunk[i].key, record + i + 1);
+				}
+				record += count;
+			}
+		}
+
+		void OpenLog() {
+
+			logFd = open(logFileName.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+			if (logFd < 0) {
+				throw std::runtime_error("could not open " + logFileName);
+			}
+
+			struct stat status{ };
+			fstat(logFd, &status);
+			size_t size = static_cast<size_t>(status.st_size);
+
+			const LogHeader expected;
+			if (size < sizeof(LogHeader)) {
+				if (ftruncate(logFd, 0) != 0 || write(logFd, &expected, sizeof(expected)) != static_cast<ssize_t>(sizeof(expected))) {
+					throw std::runtime_error("could not initialize " + logFileName);
+				}
+				size = sizeof(LogHeader);
+			}
+			else {
+				LogHeader header;
+				if (pread(logFd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+					std::memcmp(&header, &expected, sizeof(header)) != 0) {
+					throw std::runtime_error(logFileName + " is not a result log of this version");
+				}
+			}
+
+			recordCount = (size - sizeof(LogHeader)) / sizeof(Record);
+
+			// drop a partially written last record, appends must stay aligned
+			const size_t valid_size = sizeof(LogHeader) + recordCount * sizeof(Record);
+			if (valid_size != size && ftruncate(logFd, static_cast<off_t>(valid_size)) != 0) {
+				throw std::runtime_error("could not repair " + logFileName);
+			}
+		}
+
+		void OpenIndex() {
+
+			const int fd = open(indexFileName.c_str(), O_RDWR);
+			if (fd >= 0) {
+				struct stat status{ };
+				fstat(fd, &status);
+				IndexHeader header;
+				const bool usable =
+					pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+					std::memcmp(header.magic, IndexHeader{}.magic, sizeof(header.magic)) == 0 &&
+					header.version == IndexHeader{}.version &&
+					std::has_single_bit(header.capacity) &&
+					static_cast<size_t>(status.st_size) == sizeof(IndexHeader) + header.capacity * sizeof(Slot) &&
+					header.indexedRecordCount <= recordCount &&
+					recordCount * 2 <= header.capacity;
+
+				if (usable) {
+					MapIndex(fd, static_cast<size_t>(status.st_size));
+					close(fd);
+					ForEachRecord(Header().indexedRecordCount, [this](const ResultKey& key, const std::uint64_t recordNo) {
+						InsertSlot(key, recordNo);
+					});
+					Header().indexedRecordCount = recordCount;
+					return;
+				}
+				close(fd);
+			}
+
+			RebuildIndex(std::max(MIN_CAPACITY, std::bit_ceil(recordCount * 2 + 1)));
+		}
+
+		void RebuildIndex(const std::uint64_t capacity) {
+
+			const std::string temporary_file_name = indexFileName + ".tmp";
+			const size_t size = sizeof(IndexHeader) + capacity * sizeof(Slot);
+
+			const int fd = open(temporary_file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+			if (fd < 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+				if (fd >= 0) {
+					close(fd);
+				}
+				throw std::runtime_error("could not create " + temporary_file_name);
+			}
+
+			UnmapIndex();
+			MapIndex(fd, size);
+			close(fd);
+
+			Header() = IndexHeader{};
+			Header().capacity = capacity;
+			ForEachRecord(0, [this](const ResultKey& key, const std::uint64_t recordNo) {
+				InsertSlot(key, recordNo);
+			});
+			Header().indexedRecordCount = recordCount;
+
+			if (std::rename(temporary_file_name.c_str(), indexFileName.c_str()) != 0) {
+				throw std::runtime_error("could not replace " + indexFileName);
+			}
+		}
+
+		void MapIndex(const int fd, const size_t size) {
+			void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (mapping == MAP_FAILED) {
+				throw std::runtime_error("could not map " + indexFileName);
+			}
+			indexMapping = mapping;
+			indexMappingSize = size;
+		}
+
+		void UnmapIndex() noexcept {
+			if (indexMapping != nullptr) {
+				munmap(indexMapping, indexMappingSize);
+				indexMapping = nullptr;
+				indexMappingSize = 0;
+			}
+		}
+	};
+
+}
+
+#endif /* cache_h */
@@ -0,0 +1,117 @@
+//
+//  calendar.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef calendar_h
+#define calendar_h
+
+#include "types.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+namespace ba {
+
+	// UTC timestamps of a series for O(log n) date lookups. Windows are spans into the bars, so testing a
+	// sub-period copies nothing; the bars must outlive the index. Bars without a time are dated by their date string.
+	template <typename BarType>
+	class IndexedSeries final
+	{
+	private:
+		std::span<const BarType> bars;
+		std::vector<TimestampType> times;
+
+	public:
+
+		explicit IndexedSeries(const std::span<const BarType> bars) : bars(bars) {
+
+			times.reserve(bars.size());
+			for (const BarType& bar : bars) {
+				const TimestampType time = TimestampOf(bar);
+				if (!times.empty() && time < times.back()) {
+					throw std::invalid_argument("bars are not in time order");
+				}
+				times.push_back(time);
+			}
+		}
+
+		explicit IndexedSeries(const std::vector<BarType>& bars) : IndexedSeries(std::span<const BarType>(bars)) { }
+		explicit IndexedSeries(std::vector<BarType>&&) = delete;
+
+		std::span<const BarType> Bars() const noexcept {
+			return bars;
+		}
+
+		const std::vector<TimestampType>& Times() const noexcept {
+			return times;
+		}
+
+		// index of the first bar at or after the time, size() when there is none
+		size_t LowerBound(const TimestampType time) const noexcept {
+			return std::lower_bound(times.begin(), times.end(), time) - times.begin();
+		}
+
+		std::optional<size_t> IndexOf(const TimestampType time) const noexcept {
+			const size_t index = LowerBound(time);
+			return index < times.size() && times[index] == time ? std::optional{ index } : std::nullopt;
+		}
+
+		// bars in [from, until)
+		std::span<const BarType> Between(const TimestampType from, const TimestampType until) const noexcept {
+			const size_t first = LowerBound(from);
+			const size_t last = std::max(first, LowerBound(until));
+			return bars.subspan(first, last - first);
+		}
+
+		// bars dated from the first date up to but excluding the second, dates as accepted by TimeUtils::TimestampFromString
+		std::span<const BarType> Between(const std::string& from, const std::string& until) const {
+			return Between(ParseDate(from), ParseDate(until));
+		}
+
+		std::span<const BarType> Year(const int year) const noexcept {
+			return Between(TimeUtils::DaysFromCivil(year, 1, 1) * 86400, TimeUtils::DaysFromCivil(year + 1, 1, 1) * 86400);
+		}
+
+		std::span<const BarType> Month(const int year, const unsigned month) const noexcept {
+			const int next_year = month == 12 ? year + 1 : year;
+			const unsigned next_month = month == 12 ? 1 : month + 1;
+			return Between(TimeUtils::DaysFromCivil(year, month, 1) * 86400, TimeUtils::DaysFromCivil(next_year, next_month, 1) * 86400);
+		}
+
+	private:
+
+		static TimestampType TimestampOf(const Bar& bar) {
+			if (bar.time != 0) {
+				return bar.time;
+			}
+			return ParseDate(bar.date);
+		}
+
+		static TimestampType TimestampOf(const PackedBar& bar) noexcept {
+			return bar.time;
+		}
+
+		static TimestampType ParseDate(const std::string& date) {
+			const auto timestamp = TimeUtils::TimestampFromString(date);
+			if (!timestamp) {
+				throw std::invalid_argument("not a date: " + date);
+			}
+			return *timestamp;
+		}
+	};
+
+	IndexedSeries(const std::vector<Bar>&) -> IndexedSeries<Bar>;
+	IndexedSeries(std::span<const Bar>) -> IndexedSeries<Bar>;
+	IndexedSeries(std::span<const PackedBar>) -> IndexedSeries<PackedBar>;
+
+}
+
+#endif /* calendar_h */
@@ -0,0 +1,112 @@
+//
+//  checkpoint.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef checkpoint_h
+#define checkpoint_h
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <string>
+#include <type_traits>
+#include <stdexcept>
+
+namespace ba {
+
+	// Binary archives used for checkpoints, values are written in native layout.
+	// Strategies that can be checkpointed expose their mutable state with one hook used for both directions:
+	//
+	//   template<typename Archive>
+	//   void Serialize(Archive& archive) { archive(stoploss_percentage_to_buy, furthest_bid, stoploss_value); }
+	//
+	// The values derived from the params are serialized too: params() is only a rounded view of them, so a strategy
+	// constructed from params() may differ from the checkpointed one in the last bits.
+
+	class CheckpointWriter final
+	{
+	private:
+		std::ostream& out;
+
+	public:
+
+		explicit CheckpointWriter(std::ostream& out) noexcept : out(out) { }
+
+		template<typename... Types>
+		void operator()(const Types&... values) {
+			(Write(values), ...);
+			if (!out) {
+				throw std::runtime_error("checkpoint could not be written");
+			}
+		}
+
+	private:
+
+		template<typename T>
+		void Write(const T& value) {
+			static_assert(std::is_trivially_copyable_v<T>, "checkpoint values must be trivially copyable");
+			out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		void Write(const std::string& value) {
+			Write(static_cast<std::uint64_t>(value.size()));
+			out.write(value.data(), value.size());
+		}
+
+		template<typename T>
+		void Write(const std::vector<T>& values) {
+			static_assert(std::is_trivially_copyable_v<T>, "checkpoint values must be trivially copyable");
+			Write(static_cast<std::uint64_t>(values.size()));
+			out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+		}
+	};
+
+	class CheckpointReader final
+	{
+	private:
+		std::istream& in;
+
+	public:
+
+		explicit CheckpointReader(std::istream& in) noexcept : in(in) { }
+
+		template<typename... Types>
+		void operator()(Types&... values) {
+			(Read(values), ...);
+			if (!in) {
+				throw std::runtime_error("checkpoint is truncated");
+			}
+		}
+
+	private:
+
+		template<typename T>
+		void Read(T& value) {
+			static_assert(std::is_trivially_copyable_v<T>, "checkpoint values must be trivially copyable");
+			in.read(reinterpret_cast<char*>(&value), sizeof(T));
+		}
+
+		void Read(std::string& value) {
+			std::uint64_t size = 0;
+			Read(size);
+			value.resize(in ? size : 0);
+			in.read(value.data(), value.size());
+		}
+
+		template<typename T>
+		void Read(std::vector<T>& values) {
+			static_assert(std::is_trivially_copyable_v<T>, "checkpoint values must be trivially copyable");
+			std::uint64_t size = 0;
+			Read(size);
+			values.resize(in ? size : 0);
+			in.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T));
+		}
+	};
+
+}
+
+#endif /* checkpoint_h */
@@ -0,0 +1,249 @@
+//
+//  compress.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef compress_h
+#define compress_h
+
+#include "enums.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace ba {
+
+	// Doubles XOR-ed with the previous value and bit packed, as in Facebook's Gorilla.
+	// An unchanged value takes 1 bit, which is every bar of an equity curve while the position is closed;
+	// a change whose meaningful bits fit the previous window takes 2 bits plus those bits.
+	// Values are appended and decoded in order.
+	class CompressedSeries final
+	{
+	private:
+		std::vector<std::uint64_t> words;
+		std::uint64_t bitCount{ 0 };
+		std::uint64_t count{ 0 };
+		std::uint64_t previous{ 0 };
+		std::uint8_t  leading{ 64 };
+		std::uint8_t  trailing{ 0 };
+
+	public:
+
+		void Append(const double value) {
+
+			const std::uint64_t bits = std::bit_cast<std::uint64_t>(value);
+
+			if (count++ == 0) {
+				Write(bits, 64);
+				previous = bits;
+				return;
+			}
+
+			const std::uint64_t difference = bits ^ previous;
+			previous = bits;
+
+			if (difference == 0) {
+				Write(0, 1);
+				return;
+			}
+
+			const std::uint8_t difference_leading = static_cast<std::uint8_t>(std::min(std::countl_zero(difference), 63));
+			const std::uint8_t difference_trailing = static_cast<std::uint8_t>(std::countr_zero(difference));
+
+			if (leading != 64 && difference_leading >= leading && difference_trailing >= trailing) {
+				Write(1, 1);
+				Write(0, 1);
+				Write(difference >> trailing, 64 - leading - trailing);
+				return;
+			}
+
+			leading = difference_leading;
+			trailing = difference_trailing;
+			const unsigned meaningful = 64 - leading - trailing;
+
+			Write(1, 1);
+			Write(1, 1);
+			Write(leading, 6);
+			Write(meaningful - 1, 6);
+			Write(difference >> trailing, meaningful);
+		}
+
+		size_t size() const noexcept {
+			return count;
+		}
+
+		bool empty() const noexcept {
+			return count == 0;
+		}
+
+		size_t ByteCount() const noexcept {
+			return (bitCount + 7) / 8;
+		}
+
+		// calls fn(double) for every value in order
+		template <typename Function>
+		void ForEach(Function&& fn) const {
+
+			size_t position = 0;
+			std::uint64_t value = 0;
+			unsigned window_leading = 0;
+			unsigned window_trailing = 0;
+
+			for (std::uint64_t i = 0; i < count; ++i) {
+
+				if (i == 0) {
+					value = Read(position, 64);
+				}
+				else if (Read(position, 1) != 0) {
+					if (Read(position, 1) != 0) {
+						window_leading = static_cast<unsigned>(Read(position, 6));
+						window_trailing = 64 - window_leading - static_cast<unsigned>(Read(position, 6) + 1);
+					}
+					value ^= Read(position, 64 - window_leading - window_trailing) << window_trailing;
+				}
+				fn(std::bit_cast<double>(value));
+			}
+		}
+
+		std::vector<double> Decode() const {
+			std::vector<double> values;
+			values.reserve(count);
+			ForEach([&values](const double value) { values.push_back(value); });
+			return values;
+		}
+
+		template<typename Archive>
+		void Serialize(Archive& archive) {
+			archive(words, bitCount, count, previous, leading, trailing);
+		}
+
+	private:
+
+		void Write(const std::uint64_t value, const unsigned length) {
+			if (length == 0) {
+				return;
+			}
+			const unsigned offset = static_cast<unsigned>(bitCount % 64);
+			if (offset == 0) {
+				words.push_back(0);
+			}
+			words.back() |= value << offset;
+			if (offset + length > 64) {
+				words.push_back(value >> (64 - offset));
+			}
+			bitCount += length;
+		}
+
+		std::uint64_t Read(size_t& position, const unsigned length) const noexcept {
+			if (length == 0) {
+				return 0;
+			}
+			const size_t word = position / 64;
+			const unsigned offset = static_cast<unsigned>(position % 64);
+			std::uint64_t value = words[word] >> offset;
+			if (offset + length > 64) {
+				value |= words[word + 1] << (64 - offset);
+			}
+			position += length;
+			return length == 64 ? value : value & ((std::uint64_t(1) << length) - 1);
+		}
+	};
+
+	// Order logs as varint bar number deltas, zigzag varint position amounts and an order type byte,
+	// with net worth, balance and price each in their own CompressedSeries.
+	class CompressedOrderLogs final
+	{
+	private:
+		std::vector<std::uint8_t> bytes;
+		CompressedSeries netWorths;
+		CompressedSeries balances;
+		CompressedSeries prices;
+		std::uint32_t previousBarNo{ 0 };
+
+	public:
+
+		void Append(const std::uint32_t barNo,
+					const double netWorth,
+					const double balance,
+					const double price,
+					const std::int32_t positionAmount,
+					const OrderType orderType)
+		{
+			WriteVarint(barNo - previousBarNo);
+			previousBarNo = barNo;
+			WriteVarint((static_cast<std::uint32_t>(positionAmount) << 1) ^ static_cast<std::uint32_t>(positionAmount >> 31));
+			bytes.push_back(static_cast<std::uint8_t>(orderType));
+			netWorths.Append(netWorth);
+			balances.Append(balance);
+			prices.Append(price);
+		}
+
+		size_t size() const noexcept {
+			return netWorths.size();
+		}
+
+		bool empty() const noexcept {
+			return netWorths.empty();
+		}
+
+		size_t ByteCount() const noexcept {
+			return bytes.size() + netWorths.ByteCount() + balances.ByteCount() + prices.ByteCount();
+		}
+
+		// calls fn(barNo, netWorth, balance, price, positionAmount, orderType) for every order in order
+		template <typename Function>
+		void ForEach(Function&& fn) const {
+
+			const std::vector<double> net_worths = netWorths.Decode();
+			const std::vector<double> balance_values = balances.Decode();
+			const std::vector<double> price_values = prices.Decode();
+
+			size_t position = 0;
+			std::uint32_t bar_no = 0;
+
+			for (size_t i = 0; i < net_worths.size(); ++i) {
+				bar_no += ReadVarint(position);
+				const std::uint32_t zigzag = ReadVarint(position);
+				const std::int32_t position_amount = static_cast<std::int32_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+				const OrderType order_type = static_cast<OrderType>(bytes[position++]);
+				fn(bar_no, net_worths[i], balance_values[i], price_values[i], position_amount, order_type);
+			}
+		}
+
+		template<typename Archive>
+		void Serialize(Archive& archive) {
+			archive(bytes, previousBarNo);
+			netWorths.Serialize(archive);
+			balances.Serialize(archive);
+			prices.Serialize(archive);
+		}
+
+	private:
+
+		void WriteVarint(std::uint32_t value) {
+			while (value >= 0x80) {
+				bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+				value >>= 7;
+			}
+			bytes.push_back(static_cast<std::uint8_t>(value));
+		}
+
+		std::uint32_t ReadVarint(size_t& position) const noexcept {
+			std::uint32_t value = 0;
+			for (unsigned shift = 0; ; shift += 7) {
+				const std::uint8_t byte = bytes[position++];
+				value |= std::uint32_t(byte & 0x7F) << shift;
+				if ((byte & 0x80) == 0) {
+					return value;
+				}
+			}
+		}
+	};
+
+}
+
+#endif /* compress_h */
@@ -0,0 +1,873 @@
+//
+//  daemon.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef daemon_h
+#define daemon_h
+
+#include "types.h"
+#include "utils.h"
+#include "checkpoint.h"
+#include "cache.h"
+#include "prepared.h"
+#include "tester.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ba {
+
+	// Wire format over a Unix stream socket, native endianness:
+	//   on connect the client sends "BADQ" | uint32 version and the daemon answers with the same bytes
+	//   then every request and response is a Frame followed by length bytes of payload,
+	//   a response's Frame carries the nanoseconds the daemon spent on the request
+	// Payloads are written with CheckpointWriter:
+	//   Put      ticker | PackedBar records | date of every bar                          -> nothing
+	//   Load     ticker | first date | last date | interval                             -> uint64 bar count
+	//   Drop     ticker                                                                 -> nothing
+	//   Backtest strategy | ticker | params | balance | commission rate | TestOptions    -> summary
+	//   Sweep    strategy | ticker | uint64 count | params of every permutation | ... -> uint64 count | summaries
+	//   Shutdown                                                                        -> nothing
+	// Summaries are written with WriteSummary. An error response carries the message of the exception.
+	struct DaemonFormat
+	{
+		static constexpr char          MAGIC[4]{ 'B', 'A', 'D', 'Q' };
+		static constexpr std::uint32_t VERSION{ 2 };
+		static constexpr std::uint64_t MAX_PAYLOAD{ std::uint64_t(1) << 28 };
+		static constexpr size_t        RECEIVE_CHUNK{ size_t(1) << 20 }; // a payload grows as its bytes arrive, not by its announced length
+
+		enum Status : std::uint32_t
+		{
+			OK, FAILED
+		};
+
+		struct Frame
+		{
+			DaemonRequest request;
+			std::uint32_t status;
+			std::uint64_t length;
+			std::uint64_t elapsed;
+		};
+
+		static void Send(const int fd, const void* data, size_t size) {
+			const char* cursor = static_cast<const char*>(data);
+			while (size != 0) {
+				const ssize_t sent = send(fd, cursor, size, MSG_NOSIGNAL);
+				if (sent < 0 && errno == EINTR) {
+					continue;
+				}
+				if (sent <= 0) {
+					throw std::runtime_error("daemon connection is closed");
+				}
+				cursor += sent;
+				size -= static_cast<size_t>(sent);
+			}
+		}
+
+		// false when the peer closed the connection before the first byte
+		static bool Receive(const int fd, void* data, size_t size) {
+			char* cursor = static_cast<char*>(data);
+			const size_t expected = size;
+			while (size != 0) {
+				const ssize_t received = recv(fd, cursor, size, 0);
+				if (received < 0 && errno == EINTR) {
+					continue;
+				}
+				if (received == 0 && size == expected) {
+					return false;
+				}
+				if (received <= 0) {
+					throw std::runtime_error("daemon connection is closed");
+				}
+				cursor += received;
+				size -= static_cast<size_t>(received);
+			}
+			return true;
+		}
+
+		static void SendFrame(const int fd, const DaemonRequest request, const std::uint32_t status, const std::string& payload,
+							  const std::chrono::nanoseconds elapsed = std::chrono::nanoseconds(0)) {
+			if (payload.size() > MAX_PAYLOAD) {
+				throw std::length_error("daemon frame is too large");
+			}
+			const Frame frame{ request, status, payload.size(), static_cast<std::uint64_t>(elapsed.count()) };
+			Send(fd, &frame, sizeof(frame));
+			Send(fd, payload.data(), payload.size());
+		}
+
+		static bool ReceiveFrame(const int fd, Frame& frame, std::string& payload) {
+			if (!Receive(fd, &frame, sizeof(frame))) {
+				return false;
+			}
+			if (frame.length > MAX_PAYLOAD) {
+				throw std::runtime_error("daemon frame is too large");
+			}
+			payload.clear();
+			while (payload.size() < frame.length) {
+				const size_t offset = payload.size();
+				payload.resize(offset + static_cast<size_t>(std::min<std::uint64_t>(RECEIVE_CHUNK, frame.length - offset)));
+				if (!Receive(fd, payload.data() + offset, payload.size() - offset)) {
+					throw std::runtime_error("daemon connection is closed");
+				}
+			}
+			return true;
+		}
+
+		static sockaddr_un Address(const std::string& socketPath) {
+			sockaddr_un address{ };
+			address.sun_family = AF_UNIX;
+			if (socketPath.size() >= sizeof(address.sun_path)) {
+				throw std::invalid_argument("socket path is too long");
+			}
+			std::copy(socketPath.begin(), socketPath.end(), address.sun_path);
+			return address;
+		}
+	};
+
+	// Threads that live as long as the pool and run posted tasks in order.
+	// ForEachIndex hands indices to idle workers and to the calling thread, which may be a worker itself:
+	// the caller keeps taking indices, so a call from a task finishes even when every other worker is busy.
+	class WorkerPool final
+	{
+	private:
+		std::mutex                        mutex;
+		std::condition_variable           posted;
+		std::deque<std::function<void()>> tasks;
+		std::vector<std::thread>          workers;
+		bool                              stopping{ false };
+
+	public:
+
+		explicit WorkerPool(size_t threadCount = 0) {
+			if (threadCount == 0) {
+				threadCount = ParallelUtils::DefaultThreadCount();
+			}
+			workers.reserve(threadCount);
+			for (size_t i = 0; i < threadCount; ++i) {
+				workers.emplace_back([this] { Work(); });
+			}
+		}
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		// tasks posted before are run first
+		~WorkerPool() {
+			{
+				std::lock_guard lock(mutex);
+				stopping = true;
+			}
+			posted.notify_all();
+			for (auto& worker : workers) {
+				worker.join();
+			}
+		}
+
+		size_t size() const noexcept { return workers.size(); }
+
+		// the task must not throw
+		void Post(std::function<void()> task) {
+			{
+				std::lock_guard lock(mutex);
+				tasks.push_back(std::move(task));
+			}
+			posted.notify_one();
+		}
+
+		// calls fn(index) for every index in [0, count), the first exception is rethrown on the calling thread
+		template<typename Function>
+		void ForEachIndex(const size_t count, Function&& fn) {
+
+			// helpers run after the call returned find no index left and leave without touching fn
+			struct Progress
+			{
+				std::mutex              mutex;
+				std::condition_variable finished;
+				size_t                  next{ 0 };
+				size_t                  running{ 0 };
+				std::exception_ptr      exception;
+			};
+
+			const auto progress = std::make_shared<Progress>();
+
+			const auto take = [progress, count, &fn] {
+				std::unique_lock lock(progress->mutex);
+				while (progress->next < count) {
+					const size_t index = progress->next++;
+					progress->running++;
+					lock.unlock();
+
+					std::exception_ptr exception;
+					try {
+						fn(index);
+					}
+					catch (...) {
+						exception = std::current_exception();
+					}
+
+					lock.lock();
+					progress->running--;
+					if (exception && !progress->exception) {
+						progress->exception = exception;
+						progress->next = count;
+					}
+				}
+				if (progress->running == 0) {
+					progress->finished.notify_all();
+				}
+			};
+
+			const size_t helper_count = std::min(workers.size(), count) - std::min<size_t>(1, count);
+			for (size_t i = 0; i < helper_count; ++i) {
+				Post(take);
+			}
+			take();
+
+			std::unique_lock lock(progress->mutex);
+			progress->finished.wait(lock, [&] { return progress->running == 0; });
+			if (progress->exception) {
+				std::rethrow_exception(progress->exception);
+			}
+		}
+
+	private:
+
+		void Work() noexcept {
+			while (true) {
+				std::function<void()> task;
+				{
+					std::unique_lock lock(mutex);
+					posted.wait(lock, [this] { return stopping || !tasks.empty(); });
+					if (tasks.empty()) {
+						return;
+					}
+					task = std::move(tasks.front());
+					tasks.pop_front();
+				}
+				task();
+			}
+		}
+	};
+
+	struct DaemonOptions
+	{
+		size_t       threadCount{ 0 };   // workers shared by every connection and sweep, 0 for one per hardware thread
+		ResultCache* cache{ nullptr };   // sweeps with RecordingMode::MetricsOnly read and fill it
+	};
+
+	// Long-running process that keeps bar series in memory and runs backtests and sweeps for clients of a Unix socket,
+	// so a script pays for a round trip and the simulation instead of process startup and loading bars.
+	// Strategies are registered by name. Serve watches the idle connections and hands every request to one pool of
+	// workers that lives as long as the daemon; the permutations of a sweep are spread over the same workers.
+	// A series is prepared once when it is put: its price columns and its cache key are kept with its bars.
+	//
+	//   BacktestDaemon daemon("/tmp/borsa.sock");
+	//   daemon.Register<TrailingStoplossStrategy>("TrailingStoploss");
+	//   daemon.Serve(); // until a client sends Shutdown or Stop() is called
+	class BacktestDaemon final
+	{
+	public:
+		// called as loader(ticker, firstDate, lastDate, interval) for Load requests
+		using Loader = std::function<std::vector<Bar>(const std::string&, const std::string&, const std::string&, const std::string&)>;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		// the columns refer to the bars, a resident series is never moved
+		struct ResidentSeries
+		{
+			const std::vector<Bar> bars;
+			const PreparedSeries   prepared;
+			const ResultKey        key;
+
+			explicit ResidentSeries(std::vector<Bar> bars)
+			: bars(std::move(bars))
+			, prepared(this->bars)
+			, key(ResultCache::SeriesKey(this->bars))
+			{ }
+		};
+
+		using Series = std::shared_ptr<const ResidentSeries>;
+
+		struct Runner
+		{
+			std::function<TestSummary(const std::vector<ParamType>&, const ResidentSeries&, MoneyType, CommissionRateType, const TestOptions&, ResultCache*)> run;
+		};
+
+		struct Connection
+		{
+			bool greeted{ false }; // the protocol header was exchanged
+			bool busy{ false };    // a worker is answering a request, Serve does not watch it
+		};
+
+		const std::string                socketPath;
+		const DaemonOptions              options;
+		Loader                           loader;
+		int                              listenFd{ -1 };
+		int                              wakeFds[2]{ -1, -1 }; // written to make Serve look at the connections again
+		std::atomic<bool>                stopping{ false };
+
+		std::map<std::string, Runner>    runners;
+		std::shared_mutex                seriesMutex;
+		std::map<std::string, Series>    series;
+
+		std::mutex                       connectionMutex;
+		std::condition_variable          connectionsClosed;
+		std::map<int, Connection>        connections;
+
+		// last member: destroyed first, its workers are joined while everything they use still exists
+		WorkerPool                       workers;
+
+	public:
+
+		// the socket accepts connections once the constructor returns, a stale socket file is replaced
+		explicit BacktestDaemon(std::string socketPath, const DaemonOptions& options = {}, Loader loader = DefaultLoader)
+		: socketPath(std::move(socketPath))
+		, options(options)
+		, loader(std::move(loader))
+		, workers(options.threadCount)
+		{
+			const sockaddr_un address = DaemonFormat::Address(this->socketPath);
+
+			if (pipe(wakeFds) != 0) {
+				throw std::runtime_error("daemon wake pipe could not be created");
+			}
+			fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+			fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+
+			listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (listenFd < 0) {
+				CloseWakeFds();
+				throw std::runtime_error("daemon socket could not be created");
+			}
+			unlink(this->socketPath.c_str());
+			if (bind(listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listenFd, SOMAXCONN) != 0) {
+				close(listenFd);
+				CloseWakeFds();
+				throw std::runtime_error("daemon could not listen on " + this->socketPath);
+			}
+		}
+
+		BacktestDaemon(const BacktestDaemon&) = delete;
+		BacktestDaemon& operator=(const BacktestDaemon&) = delete;
+
+		~BacktestDaemon() {
+			Stop();
+			CloseIdleConnections();
+			WaitForConnections();
+			close(listenFd);
+			CloseWakeFds();
+			unlink(socketPath.c_str());
+		}
+
+		// registers before Serve, strategies are constructed from the params of each request
+		template <typename StrategyType>
+		void Register(const std::string& strategyName) {
+			runners[strategyName] = Runner {
+				.run = [](const std::vector<ParamType>& params, const ResidentSeries& bars, const MoneyType balance, const CommissionRateType commissionRate, const TestOptions& testOptions, ResultCache* cache) {
+					StrategyType strategy{ params };
+					return cache != nullptr
+						? Tester::RunCachedTest(strategy, bars.prepared, bars.key, balance, commissionRate, testOptions, *cache)
+						: Tester::RunTest(strategy, bars.prepared, balance, commissionRate, testOptions);
+				}
+			};
+		}
+
+		// makes bars available to requests without a client round trip, throws for bars PreparedSeries rejects
+		void Put(const std::string& ticker, std::vector<Bar> bars) {
+			auto resident = std::make_shared<const ResidentSeries>(std::move(bars));
+			std::unique_lock lock(seriesMutex);
+			series[ticker] = std::move(resident);
+		}
+
+		// accepts connections and dispatches their requests until Stop
+		void Serve() {
+
+			std::vector<pollfd> polled;
+
+			while (true) {
+
+				polled.clear();
+				polled.push_back(pollfd{ wakeFds[0], POLLIN, 0 });
+				polled.push_back(pollfd{ listenFd, POLLIN, 0 });
+				{
+					std::lock_guard lock(connectionMutex);
+					if (stopping) {
+						break;
+					}
+					for (const auto& [fd, connection] : connections) {
+						if (!connection.busy) {
+							polled.push_back(pollfd{ fd, POLLIN, 0 });
+						}
+					}
+				}
+
+				if (poll(polled.data(), polled.size(), -1) < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					throw std::runtime_error("daemon could not poll its connections");
+				}
+
+				if (polled[0].revents != 0) {
+					char wakeups[64];
+					while (read(wakeFds[0], wakeups, sizeof(wakeups)) > 0) { }
+				}
+				if (polled[1].revents != 0) {
+					Accept();
+				}
+				for (size_t i = 2; i < polled.size(); ++i) {
+					if (polled[i].revents != 0) {
+						Dispatch(polled[i].fd);
+					}
+				}
+			}
+			CloseIdleConnections();
+			WaitForConnections();
+		}
+
+		// returns at once, Serve returns after the requests in flight are answered
+		void Stop() noexcept {
+			std::lock_guard lock(connectionMutex);
+			if (stopping.exchange(true)) {
+				return;
+			}
+			shutdown(listenFd, SHUT_RDWR);
+			for (const auto& [fd, connection] : connections) {
+				shutdown(fd, SHUT_RD);
+			}
+			Wake();
+		}
+
+	private:
+
+		static std::vector<Bar> DefaultLoader(const std::string& ticker, const std::string& firstDate, const std::string& lastDate, const std::string& interval) {
+			return DataUtils::GetBars(ticker, firstDate, lastDate, interval);
+		}
+
+		void Wake() noexcept {
+			const char wakeup = 0;
+			[[maybe_unused]] const ssize_t written = write(wakeFds[1], &wakeup, sizeof(wakeup));
+		}
+
+		void CloseWakeFds() noexcept {
+			close(wakeFds[0]);
+			close(wakeFds[1]);
+		}
+
+		void Accept() {
+
+			const int fd = accept(listenFd, nullptr, nullptr);
+			if (fd < 0) {
+				if (errno == EINTR || errno == ECONNABORTED || stopping) {
+					return;
+				}
+				throw std::runtime_error("daemon could not accept a connection");
+			}
+
+			std::lock_guard lock(connectionMutex);
+			if (stopping) {
+				close(fd);
+				return;
+			}
+			connections.emplace(fd, Connection{ });
+		}
+
+		// the connection has a request or was closed, a worker reads and answers it
+		void Dispatch(const int fd) {
+
+			bool greeted = false;
+			{
+				std::lock_guard lock(connectionMutex);
+				Connection& connection = connections.at(fd);
+				connection.busy = true;
+				greeted = connection.greeted;
+			}
+			workers.Post([this, fd, greeted] { ServeRequest(fd, greeted); });
+		}
+
+		void CloseIdleConnections() noexcept {
+			std::lock_guard lock(connectionMutex);
+			for (auto it = connections.begin(); it != connections.end(); ) {
+				if (it->second.busy) {
+					++it;
+					continue;
+				}
+				close(it->first);
+				it = connections.erase(it);
+			}
+			connectionsClosed.notify_all();
+		}
+
+		void WaitForConnections() {
+			std::unique_lock lock(connectionMutex);
+			connectionsClosed.wait(lock, [this] { return connections.empty(); });
+		}
+
+		void ServeRequest(const int fd, const bool greeted) noexcept {
+
+			bool open = false;
+			try {
+				open = greeted ? Answer(fd) : Greet(fd);
+			}
+			catch (...) {
+				// a broken connection only ends itself
+			}
+
+			std::lock_guard lock(connectionMutex);
+			if (open && !stopping) {
+				Connection& connection = connections.at(fd);
+				connection.greeted = true;
+				connection.busy = false;
+				Wake();
+				return;
+			}
+			connections.erase(fd);
+			close(fd);
+			connectionsClosed.notify_all();
+		}
+
+		// false when the client does not speak this version of the protocol
+		bool Greet(const int fd) {
+
+			char magic[4] = {0};
+			std::uint32_t version = 0;
+			if (!DaemonFormat::Receive(fd, magic, sizeof(magic)) || !DaemonFormat::Receive(fd, &version, sizeof(version)) ||
+				std::memcmp(magic, DaemonFormat::MAGIC, sizeof(magic)) != 0 || version != DaemonFormat::VERSION) {
+				return false;
+			}
+			DaemonFormat::Send(fd, DaemonFormat::MAGIC, sizeof(DaemonFormat::MAGIC));
+			DaemonFormat::Send(fd, &DaemonFormat::VERSION, sizeof(DaemonFormat::VERSION));
+			return true;
+		}
+
+		// answers one request, false when the client closed the connection
+		bool Answer(const int fd) {
+
+			DaemonFormat::Frame frame{ };
+			std::string payload;
+			if (!DaemonFormat::ReceiveFrame(fd, frame, payload)) {
+				return false;
+			}
+
+			const auto started = Clock::now();
+
+			std::istringstream in(std::move(payload));
+			std::ostringstream out;
+			std::uint32_t status = DaemonFormat::OK;
+
+			try {
+				CheckpointReader reader(in);
+				CheckpointWriter writer(out);
+				Handle(frame.request, reader, writer);
+				if (out.tellp() > static_cast<std::streamoff>(DaemonFormat::MAX_PAYLOAD)) {
+					throw std::length_error("daemon response is too large");
+				}
+			}
+			catch (const std::exception& e) {
+				out.str(e.what());
+				status = DaemonFormat::FAILED;
+			}
+
+			DaemonFormat::SendFrame(fd, frame.request, status, out.str(), Clock::now() - started);
+
+			if (frame.request == DaemonRequest::Shutdown && status == DaemonFormat::OK) {
+				Stop();
+			}
+			return true;
+		}
+
+		void Handle(const DaemonRequest request, CheckpointReader& reader, CheckpointWriter& writer) {
+
+			switch (request) {
+
+				case DaemonRequest::Put: {
+					std::string ticker;
+					std::vector<PackedBar> packed_bars;
+					reader(ticker, packed_bars);
+					std::vector<Bar> bars;
+					bars.reserve(packed_bars.size());
+					for (const PackedBar& packed_bar : packed_bars) {
+						bars.push_back(packed_bar.ToBar());
+						reader(bars.back().date);
+					}
+					Put(ticker, std::move(bars));
+					break;
+				}
+
+				case DaemonRequest::Load: {
+					std::string ticker, first_date, last_date, interval;
+					reader(ticker, first_date, last_date, interval);
+					std::vector<Bar> bars = loader(ticker, first_date, last_date, interval);
+					const std::uint64_t bar_count = bars.size();
+					Put(ticker, std::move(bars));
+					writer(bar_count);
+					break;
+				}
+
+				case DaemonRequest::Drop: {
+					std::string ticker;
+					reader(ticker);
+					std::unique_lock lock(seriesMutex);
+					series.erase(ticker);
+					break;
+				}
+
+				case DaemonRequest::Backtest: {
+					std::string strategy_name, ticker;
+					std::vector<ParamType> params;
+					MoneyType balance = 0;
+					CommissionRateType commission_rate = 0;
+					TestOptions test_options;
+					reader(strategy_name, ticker, params, balance, commission_rate, test_options);
+
+					const Series bars = FindSeries(ticker);
+					TestSummary summary = FindRunner(strategy_name).run(params, *bars, balance, commission_rate, test_options, nullptr);
+					WriteSummary(writer, summary);
+					break;
+				}
+
+				case DaemonRequest::Sweep: {
+					std::string strategy_name, ticker;
+					std::uint64_t permutation_count = 0;
+					reader(strategy_name, ticker, permutation_count);
+					std::vector<std::vector<ParamType>> permutations(permutation_count);
+					for (auto& params : permutations) {
+						reader(params);
+					}
+					MoneyType balance = 0;
+					CommissionRateType commission_rate = 0;
+					TestOptions test_options;
+					reader(balance, commission_rate, test_options);
+
+					const Series bars = FindSeries(ticker);
+					std::vector<std::optional<TestSummary>> summaries = Sweep(FindRunner(strategy_name), permutations, *bars, balance, commission_rate, test_options);
+
+					writer(static_cast<std::uint64_t>(summaries.size()));
+					for (auto& summary : summaries) {
+						WriteSummary(writer, *summary);
+					}
+					break;
+				}
+
+				case DaemonRequest::Shutdown:
+					break;
+
+				default:
+					throw std::invalid_argument("unknown daemon request");
+			}
+		}
+
+		// run ids come from the params as in Tester::RunTestUsingParamPermutations, so the workers change no result
+		std::vector<std::optional<TestSummary>> Sweep(const Runner& runner,
+													  const std::vector<std::vector<ParamType>>& permutations,
+													  const ResidentSeries& bars,
+													  const MoneyType balance,
+													  const CommissionRateType commissionRate,
+													  const TestOptions& testOptions)
+		{
+			std::vector<std::optional<TestSummary>> summaries(permutations.size());
+
+			workers.ForEachIndex(permutations.size(), [&](const size_t index) {
+				TestOptions run_options = testOptions;
+				run_options.runId = Hasher().Add(permutations[index]).Key().low;
+				summaries[index].emplace(runner.run(permutations[index], bars, balance, commissionRate, run_options, options.cache));
+			});
+			return summaries;
+		}
+
+		Series FindSeries(const std::string& ticker) {
+			std::shared_lock lock(seriesMutex);
+			const auto it = series.find(ticker);
+			if (it == series.end()) {
+				throw std::invalid_argument("no bars for " + ticker);
+			}
+			return it->second;
+		}
+
+		const Runner& FindRunner(const std::string& strategyName) const {
+			const auto it = runners.find(strategyName);
+			if (it == runners.end()) {
+				throw std::invalid_argument("no strategy named " + strategyName);
+			}
+			return it->second;
+		}
+	};
+
+	// One connection to a BacktestDaemon, requests are answered in order. Errors of a request are thrown as std::runtime_error.
+	class DaemonClient final
+	{
+	private:
+		int                      fd{ -1 };
+		std::istringstream       response;
+		std::chrono::nanoseconds serverTime{ 0 };
+
+	public:
+
+		explicit DaemonClient(const std::string& socketPath) {
+
+			const sockaddr_un address = DaemonFormat::Address(socketPath);
+
+			fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+				if (fd >= 0) {
+					close(fd);
+				}
+				throw std::runtime_error("could not connect to " + socketPath);
+			}
+
+			char magic[4] = {0};
+			std::uint32_t version = 0;
+			try {
+				DaemonFormat::Send(fd, DaemonFormat::MAGIC, sizeof(DaemonFormat::MAGIC));
+				DaemonFormat::Send(fd, &DaemonFormat::VERSION, sizeof(DaemonFormat::VERSION));
+				if (!DaemonFormat::Receive(fd, magic, sizeof(magic)) || !DaemonFormat::Receive(fd, &version, sizeof(version)) ||
+					std::memcmp(magic, DaemonFormat::MAGIC, sizeof(magic)) != 0 || version != DaemonFormat::VERSION) {
+					throw std::runtime_error("daemon protocol does not match");
+				}
+			}
+			catch (...) {
+				close(fd);
+				throw;
+			}
+		}
+
+		DaemonClient(const DaemonClient&) = delete;
+		DaemonClient& operator=(const DaemonClient&) = delete;
+
+		~DaemonClient() {
+			close(fd);
+		}
+
+		void Put(const std::string& ticker, const std::vector<Bar>& bars) {
+			std::vector<PackedBar> packed_bars;
+			packed_bars.reserve(bars.size());
+			for (const Bar& bar : bars) {
+				packed_bars.push_back(PackedBar::FromBar(bar));
+			}
+			Request(DaemonRequest::Put, [&](CheckpointWriter& writer) {
+				writer(ticker, packed_bars);
+				for (const Bar& bar : bars) {
+					writer(bar.date);
+				}
+			});
+		}
+
+		// the daemon downloads the bars itself, returns how many it holds
+		size_t Load(const std::string& ticker, const std::string& firstDate, const std::string& lastDate, const std::string& interval = "1d") {
+			std::uint64_t bar_count = 0;
+			Request(DaemonRequest::Load, [&](CheckpointWriter& writer) {
+				writer(ticker, firstDate, lastDate, interval);
+			})(bar_count);
+			return bar_count;
+		}
+
+		void Drop(const std::string& ticker) {
+			Request(DaemonRequest::Drop, [&](CheckpointWriter& writer) {
+				writer(ticker);
+			});
+		}
+
+		TestSummary Backtest(const std::string& strategyName,
+							 const std::string& ticker,
+							 const std::vector<ParamType>& params,
+							 const MoneyType balance,
+							 const CommissionRateType commissionRate,
+							 const TestOptions& options = {})
+		{
+			CheckpointReader reader = Request(DaemonRequest::Backtest, [&](CheckpointWriter& writer) {
+				writer(strategyName, ticker, params, balance, commissionRate, options);
+			});
+			return ReadSummary(reader);
+		}
+
+		// same summaries as Tester::RunTestUsingParamPermutations on the daemon's bars
+		std::vector<TestSummary> Sweep(const std::string& strategyName,
+									   const std::string& ticker,
+									   const std::vector<std::vector<ParamType>>& paramPermutations,
+									   const MoneyType balance,
+									   const CommissionRateType commissionRate,
+									   const TestOptions& options = { .recordingMode = RecordingMode::MetricsOnly })
+		{
+			CheckpointReader reader = Request(DaemonRequest::Sweep, [&](CheckpointWriter& writer) {
+				writer(strategyName, ticker, static_cast<std::uint64_t>(paramPermutations.size()));
+				for (const auto& params : paramPermutations) {
+					writer(params);
+				}
+				writer(balance, commissionRate, options);
+			});
+
+			std::uint64_t summary_count = 0;
+			reader(summary_count);
+
+			std::vector<TestSummary> summaries;
+			summaries.reserve(summary_count);
+			for (std::uint64_t i = 0; i < summary_count; ++i) {
+				summaries.push_back(ReadSummary(reader));
+			}
+			return summaries;
+		}
+
+		// the daemon stops accepting connections and Serve returns once the requests in flight are answered
+		void Shutdown() {
+			Request(DaemonRequest::Shutdown, [](CheckpointWriter&) { });
+		}
+
+		// time the daemon spent on the last request, from reading its frame to writing the response
+		std::chrono::nanoseconds ServerTime() const noexcept { return serverTime; }
+
+	private:
+
+		template <typename Writer>
+		CheckpointReader Request(const DaemonRequest request, Writer&& write) {
+
+			std::ostringstream out;
+			CheckpointWriter writer(out);
+			write(writer);
+			DaemonFormat::SendFrame(fd, request, DaemonFormat::OK, out.str());
+
+			DaemonFormat::Frame frame{ };
+			std::string payload;
+			if (!DaemonFormat::ReceiveFrame(fd, frame, payload)) {
+				throw std::runtime_error("daemon connection is closed");
+			}
+			serverTime = std::chrono::nanoseconds(frame.elapsed);
+			if (frame.status != DaemonFormat::OK) {
+				throw std::runtime_error(payload);
+			}
+			response.str(std::move(payload));
+			response.clear();
+			return CheckpointReader(response);
+		}
+	};
+
+}
+
+#endif /* daemon_h */
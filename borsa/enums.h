@@ -20,6 +20,41 @@ namespace ba {
 		None, ClosePosition, OpenPosition
 	};
 
+	enum class RecordingMode
+	{
+		Full, MetricsOnly, Compressed
+	};
+
+	enum class ResamplingMethod
+	{
+		BlockBootstrap, ReturnShuffle
+	};
+
+	enum class Timeframe
+	{
+		Hourly, Daily, Weekly, Monthly
+	};
+
+	enum class PanelField
+	{
+		Open, High, Low, Close
+	};
+
+	enum class DaemonRequest
+	{
+		Put, Load, Drop, Backtest, Sweep, Shutdown
+	};
+
+	enum class Objective
+	{
+		FinalBalance, TotalReturn, Cagr, Sharpe, Sortino, MaxDrawdown, WinRate, TotalOrders
+	};
+
+	enum class OptimizerStop
+	{
+		Generations, Evaluations, Stagnation, Converged
+	};
+
 	const char* to_string(PositionType positionType) {
 		   switch (positionType) {
 			   case PositionType::Closed:
@@ -42,6 +77,117 @@ namespace ba {
 		   }
 	   }
 
+	const char* to_string(RecordingMode recordingMode) {
+		   switch (recordingMode) {
+			   case RecordingMode::Full:
+				   return "Full";
+			   case RecordingMode::MetricsOnly:
+				   return "MetricsOnly";
+			   case RecordingMode::Compressed:
+				   return "Compressed";
+			   default:
+				   return "None";
+		   }
+	   }
+
+	const char* to_string(ResamplingMethod resamplingMethod) {
+		   switch (resamplingMethod) {
+			   case ResamplingMethod::BlockBootstrap:
+				   return "BlockBootstrap";
+			   case ResamplingMethod::ReturnShuffle:
+				   return "ReturnShuffle";
+			   default:
+				   return "None";
+		   }
+	   }
+
+	const char* to_string(Timeframe timeframe) {
+		   switch (timeframe) {
+			   case Timeframe::Hourly:
+				   return "Hourly";
+			   case Timeframe::Daily:
+				   return "Daily";
+			   case Timeframe::Weekly:
+				   return "Weekly";
+			   case Timeframe::Monthly:
+				   return "Monthly";
+			   default:
+				   return "None";
+		   }
+	   }
+
+	const char* to_string(PanelField panelField) {
+		   switch (panelField) {
+			   case PanelField::Open:
+				   return "Open";
+			   case PanelField::High:
+				   return "High";
+			   case PanelField::Low:
+				   return "Low";
+			   case PanelField::Close:
+				   return "Close";
+			   default:
+				   return "None";
+		   }
+	   }
+
+	const char* to_string(DaemonRequest daemonRequest) {
+		   switch (daemonRequest) {
+			   case DaemonRequest::Put:
+				   return "Put";
+			   case DaemonRequest::Load:
+				   return "Load";
+			   case DaemonRequest::Drop:
+				   return "Drop";
+			   case DaemonRequest::Backtest:
+				   return "Backtest";
+			   case DaemonRequest::Sweep:
+				   return "Sweep";
+			   case DaemonRequest::Shutdown:
+				   return "Shutdown";
+			   default:
+				   return "None";
+		   }
+	   }
+
+	const char* to_string(Objective objective) {
+		   switch (objective) {
+			   case Objective::FinalBalance:
+				   return "FinalBalance";
+			   case Objective::TotalReturn:
+				   return "TotalReturn";
+			   case Objective::Cagr:
+				   return "Cagr";
+			   case Objective::Sharpe:
+				   return "Sharpe";
+			   case Objective::Sortino:
+				   return "Sortino";
+			   case Objective::MaxDrawdown:
+				   return "MaxDrawdown";
+			   case Objective::WinRate:
+				   return "WinRate";
+			   case Objective::TotalOrders:
+				   return "TotalOrders";
+			   default:
+				   return "None";
+		   }
+	   }
+
+	const char* to_string(OptimizerStop optimizerStop) {
+		   switch (optimizerStop) {
+			   case OptimizerStop::Generations:
+				   return "Generations";
+			   case OptimizerStop::Evaluations:
+				   return "Evaluations";
+			   case OptimizerStop::Stagnation:
+				   return "Stagnation";
+			   case OptimizerStop::Converged:
+				   return "Converged";
+			   default:
+				   return "None";
+		   }
+	   }
+
 }
 
 #endif /* enums_h */
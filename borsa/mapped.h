@@ -0,0 +1,187 @@
+//
+//  mapped.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef mapped_h
+#define mapped_h
+
+#include "types.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <string>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ba {
+
+	// Bar file layout, native endianness:
+	//   "BAMB" | uint32 version | uint32 record size | uint32 reserved | PackedBar records in time order
+	// The bar count follows from the file size, so a writer can keep appending to an existing file.
+	struct MappedBarFormat
+	{
+		static constexpr char          MAGIC[4]{ 'B', 'A', 'M', 'B' };
+		static constexpr std::uint32_t VERSION{ 1 };
+		static constexpr size_t        HEADER_SIZE{ 16 };
+	};
+
+	class MappedBarWriter final
+	{
+	private:
+		std::ofstream file;
+		std::vector<PackedBar> buffer;
+
+	public:
+
+		// appends to the file when it already holds bars, creates it otherwise
+		explicit MappedBarWriter(const std::string& fileName, const size_t bufferedBarCount = 64 * 1024)
+		{
+			std::ifstream existing(fileName, std::ios::binary | std::ios::ate);
+			const bool has_header = existing && static_cast<size_t>(existing.tellg()) >= MappedBarFormat::HEADER_SIZE;
+			existing.close();
+
+			file.open(fileName, std::ios::binary | std::ios::app);
+			if (!file) {
+				throw std::runtime_error("could not open " + fileName);
+			}
+			if (!has_header) {
+				const std::uint32_t header[3] = { MappedBarFormat::VERSION, sizeof(PackedBar), 0 };
+				file.write(MappedBarFormat::MAGIC, sizeof(MappedBarFormat::MAGIC));
+				file.write(reinterpret_cast<const char*>(header), sizeof(header));
+			}
+			buffer.reserve(bufferedBarCount);
+		}
+
+		MappedBarWriter(const MappedBarWriter&) = delete;
+		MappedBarWriter& operator=(const MappedBarWriter&) = delete;
+
+		~MappedBarWriter() {
+			Flush();
+		}
+
+		void Append(const PackedBar& bar) {
+			buffer.push_back(bar);
+			if (buffer.size() == buffer.capacity()) {
+				Flush();
+			}
+		}
+
+		void Append(const Bar& bar) {
+			Append(PackedBar::FromBar(bar));
+		}
+
+		void Flush() {
+			file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(PackedBar));
+			file.flush();
+			buffer.clear();
+		}
+	};
+
+	// Read-only view of a bar file. Pages are loaded by the OS on access, so series larger than RAM can be tested.
+	class MappedBarSeries final
+	{
+	private:
+		void*            mapping{ nullptr };
+		size_t           mappingSize{ 0 };
+		const PackedBar* first{ nullptr };
+		size_t           count{ 0 };
+
+	public:
+
+		explicit MappedBarSeries(const std::string& fileName) {
+
+			const int fd = open(fileName.c_str(), O_RDONLY);
+			if (fd < 0) {
+				throw std::runtime_error("could not open " + fileName);
+			}
+
+			struct stat status{ };
+			if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < MappedBarFormat::HEADER_SIZE) {
+				close(fd);
+				throw std::runtime_error(fileName + " is not a bar file");
+			}
+
+			mappingSize = static_cast<size_t>(status.st_size);
+			mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+			close(fd);
+
+			if (mapping == MAP_FAILED) {
+				mapping = nullptr;
+				throw std::runtime_error("could not map " + fileName);
+			}
+
+			const char* const bytes = static_cast<const char*>(mapping);
+			std::uint32_t header[3] = {0};
+			std::memcpy(header, bytes + sizeof(MappedBarFormat::MAGIC), sizeof(header));
+
+			if (std::memcmp(bytes, MappedBarFormat::MAGIC, sizeof(MappedBarFormat::MAGIC)) != 0 ||
+				header[0] != MappedBarFormat::VERSION || header[1] != sizeof(PackedBar)) {
+				Unmap();
+				throw std::runtime_error(fileName + " is not a bar file");
+			}
+
+			first = reinterpret_cast<const PackedBar*>(bytes + MappedBarFormat::HEADER_SIZE);
+			count = (mappingSize - MappedBarFormat::HEADER_SIZE) / sizeof(PackedBar);
+
+			madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+		}
+
+		MappedBarSeries(MappedBarSeries&& other) noexcept
+		: mapping(std::exchange(other.mapping, nullptr))
+		, mappingSize(std::exchange(other.mappingSize, 0))
+		, first(std::exchange(other.first, nullptr))
+		, count(std::exchange(other.count, 0))
+		{ }
+
+		MappedBarSeries(const MappedBarSeries&) = delete;
+		MappedBarSeries& operator=(const MappedBarSeries&) = delete;
+
+		~MappedBarSeries() {
+			Unmap();
+		}
+
+		std::span<const PackedBar> Bars() const noexcept {
+			return std::span<const PackedBar>(first, count);
+		}
+
+		size_t size() const noexcept {
+			return count;
+		}
+
+		const PackedBar& operator[](const size_t index) const noexcept {
+			return first[index];
+		}
+
+		static void Write(const std::string& fileName, const std::vector<Bar>& bars) {
+			std::remove(fileName.c_str());
+			MappedBarWriter writer(fileName);
+			for (const Bar& bar : bars) {
+				writer.Append(bar);
+			}
+		}
+
+	private:
+
+		void Unmap() noexcept {
+			if (mapping != nullptr) {
+				munmap(mapping, mappingSize);
+				mapping = nullptr;
+			}
+		}
+	};
+
+}
+
+#endif /* mapped_h */
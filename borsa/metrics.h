@@ -0,0 +1,237 @@
+//
+//  metrics.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef metrics_h
+#define metrics_h
+
+#include "enums.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+namespace ba {
+
+	struct PerformanceMetrics
+	{
+		double        totalReturn{ 0 };
+		double        cagr{ 0 };
+		double        sharpe{ 0 };
+		double        sortino{ 0 };
+		double        maxDrawdown{ 0 };
+		double        exposure{ 0 };
+		double        winRate{ 0 };
+		std::uint32_t tradeCount{ 0 };
+		std::uint32_t barCount{ 0 };
+	};
+
+	// sufficient statistics of an equity curve, shared by the batch and the incremental calculation
+	struct EquityMoments
+	{
+		std::uint32_t barCount{ 0 };
+		std::uint32_t exposedBarCount{ 0 };
+		std::uint32_t tradeCount{ 0 };
+		std::uint32_t winningTradeCount{ 0 };
+		double        initialNetWorth{ 0 };
+		double        lastNetWorth{ 0 };
+		double        sumOfReturns{ 0 };
+		double        sumOfSquaredReturns{ 0 };
+		double        sumOfSquaredDownsideReturns{ 0 };
+		double        peakNetWorth{ 0 };
+		double        maxDrawdown{ 0 };
+
+		// returns are per bar and the risk free rate is taken as zero
+		PerformanceMetrics Metrics(const double barsPerYear) const noexcept {
+
+			PerformanceMetrics metrics;
+			metrics.barCount   = barCount;
+			metrics.tradeCount = tradeCount;
+
+			if (barCount == 0 || initialNetWorth <= 0) {
+				return metrics;
+			}
+
+			const double n = barCount;
+			const double mean = sumOfReturns / n;
+			const double variance = std::max(0.0, sumOfSquaredReturns / n - mean * mean);
+			const double downside_deviation = std::sqrt(sumOfSquaredDownsideReturns / n);
+			const double annualizer = std::sqrt(barsPerYear);
+			const double growth = lastNetWorth / initialNetWorth;
+
+			metrics.totalReturn = growth - 1;
+			metrics.cagr        = growth > 0 ? std::pow(growth, barsPerYear / n) - 1 : -1;
+			metrics.sharpe      = variance > 0 ? mean / std::sqrt(variance) * annualizer : 0;
+			metrics.sortino     = downside_deviation > 0 ? mean / downside_deviation * annualizer : 0;
+			metrics.maxDrawdown = maxDrawdown;
+			metrics.exposure    = exposedBarCount / n;
+			metrics.winRate     = tradeCount != 0 ? double(winningTradeCount) / tradeCount : 0;
+
+			return metrics;
+		}
+	};
+
+	// Updated by the tester on every order and bar, keeps metrics without storing the equity curve.
+	class PerformanceAccumulator
+	{
+	private:
+		EquityMoments moments;
+		double        entryPrice{ 0 };
+
+	public:
+
+		explicit PerformanceAccumulator(const double initialNetWorth = 0) noexcept {
+			Reset(initialNetWorth);
+		}
+
+		void Reset(const double initialNetWorth) noexcept {
+			moments = EquityMoments{};
+			moments.initialNetWorth = initialNetWorth;
+			moments.lastNetWorth    = initialNetWorth;
+			moments.peakNetWorth    = initialNetWorth;
+			entryPrice = 0;
+		}
+
+		inline
+		void OrderExecuted(const OrderType orderType, const double price) noexcept {
+
+			if (orderType == OrderType::OpenPosition) {
+				entryPrice = price;
+			}
+			else if (orderType == OrderType::ClosePosition) {
+				moments.tradeCount++;
+				moments.winningTradeCount += price > entryPrice;
+			}
+		}
+
+		inline
+		void BarClosed(const double netWorth, const bool positionOpened) noexcept {
+
+			const double bar_return = moments.lastNetWorth != 0 ? netWorth / moments.lastNetWorth - 1 : 0;
+			const double downside = std::min(bar_return, 0.0);
+
+			moments.sumOfReturns                += bar_return;
+			moments.sumOfSquaredReturns         += bar_return * bar_return;
+			moments.sumOfSquaredDownsideReturns += downside * downside;
+			moments.peakNetWorth = std::max(moments.peakNetWorth, netWorth);
+			moments.maxDrawdown  = std::max(moments.maxDrawdown, 1 - netWorth / moments.peakNetWorth);
+			moments.exposedBarCount += positionOpened;
+			moments.lastNetWorth = netWorth;
+			moments.barCount++;
+		}
+
+		// net worth at the end of the last bar, zero when no bar is closed yet
+		double LastNetWorth() const noexcept {
+			return moments.barCount != 0 ? moments.lastNetWorth : 0;
+		}
+
+		const EquityMoments& Moments() const noexcept {
+			return moments;
+		}
+
+		PerformanceMetrics Metrics(const double barsPerYear = 252) const noexcept {
+			return moments.Metrics(barsPerYear);
+		}
+	};
+
+	struct MetricsUtils
+	{
+		// One pass over a recorded equity curve. The return sums run on independent lanes without branches
+		// so the compiler can keep them in vector registers; only the running peak is a true scan.
+		template<typename OrderLogCollection>
+		static PerformanceMetrics Calculate(const std::vector<double>& barEndNetWorths,
+											const OrderLogCollection& orderLogs,
+											const double initialNetWorth,
+											const double barsPerYear = 252) noexcept
+		{
+			constexpr size_t LANES = 4;
+
+			EquityMoments moments;
+			moments.initialNetWorth = initialNetWorth;
+			moments.peakNetWorth    = initialNetWorth;
+			moments.barCount        = static_cast<std::uint32_t>(barEndNetWorths.size());
+
+			if (barEndNetWorths.empty() || initialNetWorth <= 0) {
+				return moments.Metrics(barsPerYear);
+			}
+
+			const double* values = barEndNetWorths.data();
+			const size_t n = barEndNetWorths.size();
+
+			double sums[LANES] = {0};
+			double squares[LANES] = {0};
+			double downsides[LANES] = {0};
+			double peak = initialNetWorth;
+			double max_drawdown = 0;
+
+			const auto accumulate = [&](const size_t lane, const double previous, const double current) noexcept {
+				const double bar_return = current / previous - 1;
+				const double downside = std::min(bar_return, 0.0);
+				sums[lane]      += bar_return;
+				squares[lane]   += bar_return * bar_return;
+				downsides[lane] += downside * downside;
+			};
+			const auto track_drawdown = [&](const double current) noexcept {
+				peak = std::max(peak, current);
+				max_drawdown = std::max(max_drawdown, 1 - current / peak);
+			};
+
+			accumulate(0, initialNetWorth, values[0]);
+			track_drawdown(values[0]);
+
+			size_t i = 1;
+			for (; i + LANES <= n; i += LANES) {
+				for (size_t lane = 0; lane < LANES; ++lane) {
+					accumulate(lane, values[i + lane - 1], values[i + lane]);
+				}
+				for (size_t lane = 0; lane < LANES; ++lane) {
+					track_drawdown(values[i + lane]);
+				}
+			}
+			for (; i < n; ++i) {
+				accumulate(0, values[i - 1], values[i]);
+				track_drawdown(values[i]);
+			}
+
+			for (size_t lane = 0; lane < LANES; ++lane) {
+				moments.sumOfReturns                += sums[lane];
+				moments.sumOfSquaredReturns         += squares[lane];
+				moments.sumOfSquaredDownsideReturns += downsides[lane];
+			}
+			moments.lastNetWorth = values[n - 1];
+			moments.peakNetWorth = peak;
+			moments.maxDrawdown  = max_drawdown;
+
+			// a position opened on bar b (or at start, b = 0) is held at the end of bars b .. c-1 when it is closed on bar c
+			std::uint32_t opened_at = 0;
+			bool opened = false;
+			double entry_price = 0;
+			for (const auto& orderLog : orderLogs) {
+				if (orderLog.orderType == OrderType::OpenPosition) {
+					opened = true;
+					opened_at = orderLog.barNo;
+					entry_price = orderLog.price;
+				}
+				else if (orderLog.orderType == OrderType::ClosePosition && opened) {
+					opened = false;
+					moments.exposedBarCount += std::min<std::uint32_t>(orderLog.barNo, moments.barCount) - std::min<std::uint32_t>(opened_at, moments.barCount);
+					moments.tradeCount++;
+					moments.winningTradeCount += orderLog.price > entry_price;
+				}
+			}
+			if (opened) {
+				moments.exposedBarCount += moments.barCount - std::min<std::uint32_t>(opened_at, moments.barCount);
+			}
+
+			return moments.Metrics(barsPerYear);
+		}
+	};
+
+}
+
+#endif /* metrics_h */
@@ -0,0 +1,184 @@
+//
+//  montecarlo.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef montecarlo_h
+#define montecarlo_h
+
+#include "types.h"
+#include "utils.h"
+#include "random.h"
+#include "tester.h"
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <numeric>
+
+namespace ba {
+
+	struct MonteCarloOptions
+	{
+		size_t           pathCount{ 1000 };
+		ResamplingMethod method{ ResamplingMethod::BlockBootstrap };
+		size_t           blockSize{ 20 };
+		std::uint64_t    seed{ 0 };
+		size_t           threadCount{ 0 };
+	};
+
+	struct MonteCarloSummary
+	{
+		std::vector<ParamType> params;
+		std::vector<MoneyType> finalBalances;
+		std::vector<double>    maxDrawdowns;
+
+		// q in [0, 1], nearest rank
+		static double Percentile(std::vector<double> values, const double q) noexcept {
+			if (values.empty()) {
+				return 0;
+			}
+			const size_t rank = std::min(values.size() - 1, size_t(BarUtils::KeepInRange(0, q, 1) * (values.size() - 1) + 0.5));
+			std::nth_element(values.begin(), values.begin() + rank, values.end());
+			return values[rank];
+		}
+
+		double FinalBalancePercentile(const double q) const noexcept { return Percentile(finalBalances, q); }
+		double MaxDrawdownPercentile(const double q) const noexcept { return Percentile(maxDrawdowns, q); }
+	};
+
+	class MonteCarloTester final
+	{
+	public:
+
+		// Runs the strategy on options.pathCount resampled variants of the bars. A variant keeps the first bar
+		// and the dates of the original series, later bars are rebuilt from resampled (open, high, low, close)
+		// ratios to the previous close. Each worker owns one path buffer that is regenerated for every path,
+		// so memory does not grow with the path count. Path p only depends on (options.seed, p).
+		template<typename StrategyType>
+		static
+		MonteCarloSummary Run(const std::vector<ParamType>& params,
+							  const std::vector<Bar>& bars,
+							  const MoneyType balance,
+							  const CommissionRateType commissionRate,
+							  const MonteCarloOptions& options = {})
+		{
+			MonteCarloSummary summary;
+			summary.params = params;
+			summary.finalBalances.resize(options.pathCount);
+			summary.maxDrawdowns.resize(options.pathCount);
+
+			if (bars.empty() || options.pathCount == 0) {
+				return summary;
+			}
+
+			const std::vector<BarRatios> ratios = CalculateRatios(bars);
+
+			const size_t thread_count = std::min(options.threadCount != 0 ? options.threadCount : ParallelUtils::DefaultThreadCount(), options.pathCount);
+			std::atomic<size_t> next_path{ 0 };
+
+			ParallelUtils::ForEachIndex(thread_count, thread_count, [&](size_t) {
+
+				std::vector<Bar> path = bars;
+				std::vector<ID32> sources;
+
+				for (size_t path_no = next_path++; path_no < options.pathCount; path_no = next_path++) {
+
+					// the strategy gets (seed, path_no) itself, resampling uses a derived seed to keep the streams apart
+					RandomService randomService(RandomService::Mix(options.seed), path_no);
+					GenerateSources(randomService, ratios.size(), options, sources);
+					ApplyRatios(ratios, sources, path);
+
+					StrategyType strategy{ params };
+					const TestSummary test_summary = Tester::RunTest(strategy, path, balance, commissionRate, {
+						.recordingMode = RecordingMode::MetricsOnly,
+						.seed          = options.seed,
+						.runId         = path_no
+					});
+
+					summary.finalBalances[path_no] = test_summary.finalBalance;
+					summary.maxDrawdowns[path_no]  = test_summary.metrics.maxDrawdown;
+				}
+			});
+
+			return summary;
+		}
+
+	private:
+
+		struct BarRatios
+		{
+			double open{ 1 };
+			double high{ 1 };
+			double low{ 1 };
+			double close{ 1 };
+		};
+
+		// ratios[i] describes bars[i + 1] relative to bars[i].close
+		static std::vector<BarRatios> CalculateRatios(const std::vector<Bar>& bars) noexcept {
+
+			std::vector<BarRatios> ratios;
+			ratios.reserve(bars.size());
+			for (size_t i = 1; i < bars.size(); ++i) {
+				const MoneyType previous_close = bars[i - 1].close;
+				if (previous_close <= 0) {
+					ratios.push_back(BarRatios{});
+					continue;
+				}
+				ratios.push_back(BarRatios {
+					.open  = bars[i].open  / previous_close,
+					.high  = bars[i].high  / previous_close,
+					.low   = bars[i].low   / previous_close,
+					.close = bars[i].close / previous_close
+				});
+			}
+			return ratios;
+		}
+
+		static void GenerateSources(RandomService& randomService, const size_t count, const MonteCarloOptions& options, std::vector<ID32>& sources) noexcept {
+
+			sources.resize(count);
+			if (count == 0) {
+				return;
+			}
+
+			switch (options.method) {
+				case ResamplingMethod::ReturnShuffle:
+					std::iota(sources.begin(), sources.end(), ID32{ 0 });
+					for (size_t i = count - 1; i > 0; --i) {
+						std::swap(sources[i], sources[randomService.NextBelow(i + 1)]);
+					}
+					break;
+				case ResamplingMethod::BlockBootstrap: {
+					const size_t block_size = std::min(std::max<size_t>(1, options.blockSize), count);
+					for (size_t i = 0; i < count; ) {
+						const size_t block_begin = randomService.NextBelow(count - block_size + 1);
+						for (size_t j = 0; j < block_size && i < count; ++j, ++i) {
+							sources[i] = static_cast<ID32>(block_begin + j);
+						}
+					}
+					break;
+				}
+			}
+		}
+
+		static void ApplyRatios(const std::vector<BarRatios>& ratios, const std::vector<ID32>& sources, std::vector<Bar>& path) noexcept {
+
+			MoneyType previous_close = path.front().close;
+			for (size_t i = 0; i < sources.size(); ++i) {
+				const BarRatios& ratio = ratios[sources[i]];
+				Bar& bar = path[i + 1];
+				bar.open  = previous_close * ratio.open;
+				bar.high  = previous_close * ratio.high;
+				bar.low   = previous_close * ratio.low;
+				bar.close = previous_close * ratio.close;
+				previous_close = bar.close;
+			}
+		}
+	};
+
+}
+
+#endif /* montecarlo_h */
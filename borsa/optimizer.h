@@ -0,0 +1,504 @@
+//
+//  optimizer.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef optimizer_h
+#define optimizer_h
+
+#include "types.h"
+#include "utils.h"
+#include "random.h"
+#include "cache.h"
+#include "pareto.h"
+#include "tester.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
+#include <numbers>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace ba {
+
+	// CMA-ES with weighted recombination, after Hansen's tutorial "The CMA Evolution Strategy".
+	// Candidates are drawn from N(mean, stepSize^2 C) and the distribution moves towards the better half of every
+	// generation, so the search follows correlated params without a grid. Larger scores are better.
+	class CmaEs final
+	{
+	private:
+		size_t              dimension;
+		size_t              populationSize;
+		size_t              parentCount;
+		std::vector<double> weights;
+		double              effectiveParents;
+		double              cc, cs, c1, cmu, damps, expectedNorm;
+
+		std::vector<double> mean;
+		double              stepSize;
+		std::vector<double> covariance;   // row major, dimension x dimension
+		std::vector<double> axes;         // eigenvectors of the covariance in columns
+		std::vector<double> scales;       // square roots of its eigenvalues
+		std::vector<double> pathC;
+		std::vector<double> pathSigma;
+		size_t              generation{ 0 };
+
+	public:
+
+		// 4 + 3 ln(dimension) candidates per generation when populationSize is zero
+		CmaEs(std::vector<double> mean, const double stepSize, size_t populationSize = 0)
+			: dimension(mean.size()), mean(std::move(mean)), stepSize(stepSize)
+		{
+			if (dimension == 0) {
+				throw std::invalid_argument("CMA-ES needs at least one dimension");
+			}
+
+			const double n = static_cast<double>(dimension);
+			this->populationSize = populationSize != 0 ? std::max<size_t>(populationSize, 2) : 4 + static_cast<size_t>(3 * std::log(n));
+			parentCount = this->populationSize / 2;
+
+			for (size_t i = 0; i < parentCount; ++i) {
+				weights.push_back(std::log(parentCount + 0.5) - std::log(i + 1.0));
+			}
+			const double weight_sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+			double square_sum = 0;
+			for (double& weight : weights) {
+				weight /= weight_sum;
+				square_sum += weight * weight;
+			}
+			effectiveParents = 1 / square_sum;
+
+			const double mu = effectiveParents;
+			cc = (4 + mu / n) / (n + 4 + 2 * mu / n);
+			cs = (mu + 2) / (n + mu + 5);
+			c1 = 2 / ((n + 1.3) * (n + 1.3) + mu);
+			cmu = std::min(1 - c1, 2 * (mu - 2 + 1 / mu) / ((n + 2) * (n + 2) + mu));
+			damps = 1 + 2 * std::max(0.0, std::sqrt((mu - 1) / (n + 1)) - 1) + cs;
+			expectedNorm = std::sqrt(n) * (1 - 1 / (4 * n) + 1 / (21 * n * n));
+
+			covariance.assign(dimension * dimension, 0);
+			axes.assign(dimension * dimension, 0);
+			for (size_t i = 0; i < dimension; ++i) {
+				covariance[i * dimension + i] = 1;
+				axes[i * dimension + i] = 1;
+			}
+			scales.assign(dimension, 1);
+			pathC.assign(dimension, 0);
+			pathSigma.assign(dimension, 0);
+		}
+
+		size_t Dimension() const noexcept { return dimension; }
+		size_t PopulationSize() const noexcept { return populationSize; }
+		size_t Generation() const noexcept { return generation; }
+		const std::vector<double>& Mean() const noexcept { return mean; }
+		double StepSize() const noexcept { return stepSize; }
+
+		// step size along the longest axis of the distribution
+		double Spread() const noexcept {
+			return stepSize * *std::max_element(scales.begin(), scales.end());
+		}
+
+		std::vector<double> Sample(RandomService& random) const {
+
+			std::vector<double> scaled(dimension);
+			for (size_t i = 0; i < dimension; ++i) {
+				scaled[i] = scales[i] * Gaussian(random);
+			}
+
+			std::vector<double> candidate = mean;
+			for (size_t i = 0; i < dimension; ++i) {
+				double step = 0;
+				for (size_t j = 0; j < dimension; ++j) {
+					step += axes[i * dimension + j] * scaled[j];
+				}
+				candidate[i] += stepSize * step;
+			}
+			return candidate;
+		}
+
+		// one score per candidate of the generation, NaN ranks last
+		void Update(const std::vector<std::vector<double>>& candidates, const std::vector<double>& scores) {
+
+			if (candidates.size() != populationSize || scores.size() != populationSize) {
+				throw std::invalid_argument("CMA-ES update needs one score for every candidate of the generation");
+			}
+
+			std::vector<size_t> ranking(populationSize);
+			std::iota(ranking.begin(), ranking.end(), 0);
+			std::stable_sort(ranking.begin(), ranking.end(), [&](const size_t a, const size_t b) {
+				const double score_a = std::isnan(scores[a]) ? -std::numeric_limits<double>::infinity() : scores[a];
+				const double score_b = std::isnan(scores[b]) ? -std::numeric_limits<double>::infinity() : scores[b];
+				return score_a > score_b;
+			});
+
+			const std::vector<double> old_mean = mean;
+			std::vector<std::vector<double>> steps(parentCount, std::vector<double>(dimension));
+			std::vector<double> mean_step(dimension, 0);
+
+			for (size_t k = 0; k < parentCount; ++k) {
+				const std::vector<double>& parent = candidates[ranking[k]];
+				for (size_t i = 0; i < dimension; ++i) {
+					steps[k][i] = (parent[i] - old_mean[i]) / stepSize;
+					mean_step[i] += weights[k] * steps[k][i];
+				}
+			}
+			for (size_t i = 0; i < dimension; ++i) {
+				mean[i] = old_mean[i] + stepSize * mean_step[i];
+			}
+
+			// C^-1/2 * mean_step = B D^-1 B^T * mean_step
+			std::vector<double> projected(dimension, 0);
+			for (size_t j = 0; j < dimension; ++j) {
+				double value = 0;
+				for (size_t i = 0; i < dimension; ++i) {
+					value += axes[i * dimension + j] * mean_step[i];
+				}
+				value /= scales[j];
+				for (size_t i = 0; i < dimension; ++i) {
+					projected[i] += axes[i * dimension + j] * value;
+				}
+			}
+
+			const double sigma_rate = std::sqrt(cs * (2 - cs) * effectiveParents);
+			double path_sigma_norm = 0;
+			for (size_t i = 0; i < dimension; ++i) {
+				pathSigma[i] = (1 - cs) * pathSigma[i] + sigma_rate * projected[i];
+				path_sigma_norm += pathSigma[i] * pathSigma[i];
+			}
+			path_sigma_norm = std::sqrt(path_sigma_norm);
+
+			generation++;
+			const double n = static_cast<double>(dimension);
+			const bool short_path = path_sigma_norm / std::sqrt(1 - std::pow(1 - cs, 2.0 * generation)) / expectedNorm < 1.4 + 2 / (n + 1);
+			const double h_sigma = short_path ? 1 : 0;
+
+			const double c_rate = std::sqrt(cc * (2 - cc) * effectiveParents);
+			for (size_t i = 0; i < dimension; ++i) {
+				pathC[i] = (1 - cc) * pathC[i] + h_sigma * c_rate * mean_step[i];
+			}
+
+			const double keep = 1 - c1 - cmu + c1 * (1 - h_sigma) * cc * (2 - cc);
+			for (size_t i = 0; i < dimension; ++i) {
+				for (size_t j = 0; j <= i; ++j) {
+					double rank_mu = 0;
+					for (size_t k = 0; k < parentCount; ++k) {
+						rank_mu += weights[k] * steps[k][i] * steps[k][j];
+					}
+					const double value = keep * covariance[i * dimension + j] + c1 * pathC[i] * pathC[j] + cmu * rank_mu;
+					covariance[i * dimension + j] = value;
+					covariance[j * dimension + i] = value;
+				}
+			}
+
+			stepSize *= std::exp(std::min(1.0, (cs / damps) * (path_sigma_norm / expectedNorm - 1)));
+
+			Decompose();
+		}
+
+	private:
+
+		static double Gaussian(RandomService& random) noexcept {
+			const double u = 1 - random.NextDouble(); // (0, 1]
+			const double v = random.NextDouble();
+			return std::sqrt(-2 * std::log(u)) * std::cos(2 * std::numbers::pi * v);
+		}
+
+		// cyclic Jacobi rotations, the covariance is small and symmetric
+		void Decompose() {
+
+			std::vector<double> a = covariance;
+			std::fill(axes.begin(), axes.end(), 0);
+			for (size_t i = 0; i < dimension; ++i) {
+				axes[i * dimension + i] = 1;
+			}
+
+			for (int sweep = 0; sweep < 64; ++sweep) {
+
+				double off_diagonal = 0, diagonal = 0;
+				for (size_t i = 0; i < dimension; ++i) {
+					diagonal += a[i * dimension + i] * a[i * dimension + i];
+					for (size_t j = i + 1; j < dimension; ++j) {
+						off_diagonal += a[i * dimension + j] * a[i * dimension + j];
+					}
+				}
+				if (off_diagonal <= 1e-30 * diagonal) {
+					break;
+				}
+
+				for (size_t p = 0; p < dimension; ++p) {
+					for (size_t q = p + 1; q < dimension; ++q) {
+
+						const double apq = a[p * dimension + q];
+						if (apq == 0) {
+							continue;
+						}
+						const double theta = (a[q * dimension + q] - a[p * dimension + p]) / (2 * apq);
+						const double t = (theta >= 0 ? 1 : -1) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+						const double c = 1 / std::sqrt(t * t + 1);
+						const double s = t * c;
+
+						for (size_t k = 0; k < dimension; ++k) {
+							const double akp = a[k * dimension + p];
+							const double akq = a[k * dimension + q];
+							a[k * dimension + p] = c * akp - s * akq;
+							a[k * dimension + q] = s * akp + c * akq;
+						}
+						for (size_t k = 0; k < dimension; ++k) {
+							const double apk = a[p * dimension + k];
+							const double aqk = a[q * dimension + k];
+							a[p * dimension + k] = c * apk - s * aqk;
+							a[q * dimension + k] = s * apk + c * aqk;
+						}
+						for (size_t k = 0; k < dimension; ++k) {
+							const double vkp = axes[k * dimension + p];
+							const double vkq = axes[k * dimension + q];
+							axes[k * dimension + p] = c * vkp - s * vkq;
+							axes[k * dimension + q] = s * vkp + c * vkq;
+						}
+					}
+				}
+			}
+
+			for (size_t i = 0; i < dimension; ++i) {
+				scales[i] = std::sqrt(std::max(a[i * dimension + i], 1e-20));
+			}
+		}
+	};
+
+	// params are rounded to low + a multiple of step when step is positive
+	struct ParamBound
+	{
+		ParamType low{ 0 };
+		ParamType high{ 0 };
+		ParamType step{ 0 };
+	};
+
+	struct OptimizerOptions
+	{
+		Objective              objective{ Objective::FinalBalance };
+		std::uint64_t          seed{ 0 };
+		size_t                 populationSize{ 0 };     // 4 + 3 ln(param count) when zero
+		size_t                 maxGenerations{ 100 };
+		size_t                 maxEvaluations{ 0 };     // no limit when zero
+		size_t                 patience{ 20 };          // generations without improvement before stopping, never when zero
+		double                 tolerance{ 1e-9 };       // relative improvement counted as one
+		double                 initialStepSize{ 0.3 };  // as a fraction of every param range
+		double                 minStepSize{ 1e-6 };     // converged when the spread falls below it, as a fraction of the ranges
+		size_t                 maxResamples{ 20 };      // draws of a candidate before an infeasible one is kept
+		size_t                 threadCount{ 0 };
+		std::vector<ParamType> initialParams{ };        // the middle of the bounds when empty
+	};
+
+	struct GenerationReport
+	{
+		size_t                 generation{ 0 };
+		size_t                 evaluations{ 0 };  // runs simulated so far
+		double                 bestScore{ 0 };    // of this generation
+		double                 meanScore{ 0 };    // of its feasible candidates
+		double                 bestScoreSoFar{ 0 };
+		double                 spread{ 0 };       // as a fraction of the ranges
+		std::vector<ParamType> bestParams{ };     // of this generation
+	};
+
+	struct OptimizationResult
+	{
+		std::vector<ParamType>        bestParams{ };
+		double                        bestScore{ -std::numeric_limits<double>::infinity() };
+		std::optional<TestSummary>    bestSummary{ };
+		size_t                        evaluations{ 0 };
+		size_t                        generations{ 0 };
+		OptimizerStop                 stop{ OptimizerStop::Generations };
+		std::vector<GenerationReport> history{ };
+	};
+
+	// Searches the params of a strategy with CMA-ES instead of a grid, for strategies with too many params
+	// for RangeUtils::Permutations. Every generation is a parallel batch of Tester::RunTest calls scored by
+	// ParetoUtils::Score, larger is better. The search works on the params scaled to [0, 1] by their bounds.
+	// Candidates outside the bounds or failing the constraint are drawn again, up to maxResamples times; the last
+	// draw is then moved into the bounds, and if it still fails the constraint it scores -inf without a run.
+	// Candidates are drawn on the calling thread from RandomService(seed, generation) and runs get their params'
+	// hash as run id, so a seed gives the same result with any thread count. Params seen before, which rounding
+	// to steps makes common, are scored from memory.
+	template<typename StrategyType>
+	class EvolutionaryOptimizer final
+	{
+	public:
+
+		using Constraint = std::function<bool(const std::vector<ParamType>&)>;
+
+		// candidates are run with RecordingMode::MetricsOnly, the other test options are used as given
+		// bars is a std::vector<Bar>, a TimeframeSeries or a PreparedSeries shared by every run
+		template<typename SeriesType>
+		static
+		OptimizationResult Optimize(const std::vector<ParamBound>& bounds,
+									const SeriesType& bars,
+									const MoneyType balance,
+									const CommissionRateType commissionRate,
+									const TestOptions& options = {},
+									const OptimizerOptions& optimizerOptions = {},
+									const Constraint& constraint = {})
+		{
+			for (const ParamBound& bound : bounds) {
+				if (!(bound.low < bound.high) || bound.step < 0) {
+					throw std::invalid_argument("param bounds must have low < high and a step that is not negative");
+				}
+			}
+
+			std::vector<double> start(bounds.size(), 0.5);
+			if (!optimizerOptions.initialParams.empty()) {
+				if (optimizerOptions.initialParams.size() != bounds.size()) {
+					throw std::invalid_argument("initial params must have one value for every bound");
+				}
+				for (size_t i = 0; i < bounds.size(); ++i) {
+					start[i] = std::clamp((optimizerOptions.initialParams[i] - bounds[i].low) / (bounds[i].high - bounds[i].low), 0.0, 1.0);
+				}
+			}
+
+			CmaEs search(std::move(start), optimizerOptions.initialStepSize, optimizerOptions.populationSize);
+			const size_t population_size = search.PopulationSize();
+
+			TestOptions run_options = options;
+			run_options.recordingMode = RecordingMode::MetricsOnly;
+
+			OptimizationResult result;
+			std::map<std::vector<ParamType>, double> scored;
+			double best_for_patience = -std::numeric_limits<double>::infinity();
+			size_t stale_generations = 0;
+
+			while (true) {
+
+				if (result.generations == optimizerOptions.maxGenerations) {
+					result.stop = OptimizerStop::Generations;
+					break;
+				}
+				if (optimizerOptions.maxEvaluations != 0 && result.evaluations + population_size > optimizerOptions.maxEvaluations) {
+					result.stop = OptimizerStop::Evaluations;
+					break;
+				}
+
+				RandomService random(optimizerOptions.seed, result.generations);
+
+				std::vector<std::vector<double>> candidates(population_size);
+				std::vector<std::vector<ParamType>> candidate_params(population_size);
+				std::vector<double> scores(population_size, -std::numeric_limits<double>::infinity());
+				std::vector<bool> feasible(population_size, false);
+
+				for (size_t k = 0; k < population_size; ++k) {
+					for (size_t draw = 0; draw <= optimizerOptions.maxResamples; ++draw) {
+						candidates[k] = search.Sample(random);
+						const bool inside = std::all_of(candidates[k].begin(), candidates[k].end(), [](const double value) { return value >= 0 && value <= 1; });
+						if (inside && (!constraint || constraint(Decode(candidates[k], bounds)))) {
+							break;
+						}
+					}
+					for (double& value : candidates[k]) {
+						value = std::clamp(value, 0.0, 1.0);
+					}
+					candidate_params[k] = Decode(candidates[k], bounds);
+					feasible[k] = !constraint || constraint(candidate_params[k]);
+				}
+
+				// params to simulate, each once
+				std::vector<size_t> runs;
+				for (size_t k = 0; k < population_size; ++k) {
+					if (!feasible[k] || scored.contains(candidate_params[k])) {
+						continue;
+					}
+					const bool repeated = std::any_of(runs.begin(), runs.end(), [&](const size_t run) { return candidate_params[run] == candidate_params[k]; });
+					if (!repeated) {
+						runs.push_back(k);
+					}
+				}
+
+				std::vector<std::optional<TestSummary>> summaries(runs.size());
+				ParallelUtils::ForEachIndex(runs.size(), optimizerOptions.threadCount, [&](const size_t run) {
+					const std::vector<ParamType>& params = candidate_params[runs[run]];
+					StrategyType strategy {params};
+					TestOptions candidate_options = run_options;
+					candidate_options.runId = Hasher().Add(params).Key().low;
+					summaries[run].emplace(Tester::RunTest(strategy, bars, balance, commissionRate, candidate_options));
+				});
+
+				for (size_t run = 0; run < runs.size(); ++run) {
+					const double score = ParetoUtils::Score(*summaries[run], optimizerOptions.objective);
+					scored.emplace(candidate_params[runs[run]], score);
+					if (score > result.bestScore || result.bestParams.empty()) {
+						result.bestScore = score;
+						result.bestParams = candidate_params[runs[run]];
+						result.bestSummary.emplace(std::move(*summaries[run]));
+					}
+				}
+				result.evaluations += runs.size();
+
+				GenerationReport report{ .generation = result.generations, .evaluations = result.evaluations };
+				report.bestScore = -std::numeric_limits<double>::infinity();
+				size_t feasible_count = 0;
+				for (size_t k = 0; k < population_size; ++k) {
+					if (!feasible[k]) {
+						continue;
+					}
+					scores[k] = scored.at(candidate_params[k]);
+					report.meanScore += scores[k];
+					feasible_count++;
+					if (scores[k] > report.bestScore || report.bestParams.empty()) {
+						report.bestScore = scores[k];
+						report.bestParams = candidate_params[k];
+					}
+				}
+				report.meanScore = feasible_count != 0 ? report.meanScore / feasible_count : std::numeric_limits<double>::quiet_NaN();
+
+				search.Update(candidates, scores);
+				result.generations++;
+
+				report.bestScoreSoFar = result.bestScore;
+				report.spread = search.Spread();
+				result.history.push_back(std::move(report));
+
+				const double least_improvement = std::isinf(best_for_patience) ? 0 : optimizerOptions.tolerance * std::max(1.0, std::abs(best_for_patience));
+				if (result.bestScore > best_for_patience + least_improvement) {
+					best_for_patience = result.bestScore;
+					stale_generations = 0;
+				}
+				else if (optimizerOptions.patience != 0 && ++stale_generations >= optimizerOptions.patience) {
+					result.stop = OptimizerStop::Stagnation;
+					break;
+				}
+
+				if (search.Spread() < optimizerOptions.minStepSize) {
+					result.stop = OptimizerStop::Converged;
+					break;
+				}
+			}
+			return result;
+		}
+
+	private:
+
+		static std::vector<ParamType> Decode(const std::vector<double>& scaled, const std::vector<ParamBound>& bounds) {
+
+			std::vector<ParamType> params(bounds.size());
+			for (size_t i = 0; i < bounds.size(); ++i) {
+				const ParamBound& bound = bounds[i];
+				ParamType param = bound.low + std::clamp(scaled[i], 0.0, 1.0) * (bound.high - bound.low);
+				if (bound.step > 0) {
+					param = bound.low + std::round((param - bound.low) / bound.step) * bound.step;
+					while (param > bound.high) {
+						param -= bound.step;
+					}
+				}
+				params[i] = param;
+			}
+			return params;
+		}
+	};
+
+}
+
+#endif /* optimizer_h */
@@ -0,0 +1,397 @@
+//
+//  panel.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef panel_h
+#define panel_h
+
+#include "types.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ba {
+
+	// Bars of many tickers aligned on the union of their dates. Every field is a dates × tickers matrix stored
+	// date by date, so the cross section of a date is one contiguous row. A ticker without a bar on a date has
+	// a zero in the mask and NaN in every field.
+	class Panel final
+	{
+	private:
+		static constexpr size_t FIELD_COUNT = 4;
+
+		std::vector<std::string> dates;
+		std::vector<TimestampType> times;
+		std::vector<std::string> tickers;
+		std::array<std::vector<MoneyType>, FIELD_COUNT> fields;
+		std::vector<std::uint8_t> mask;
+
+	public:
+
+		// bars are matched by time and date, so series loaded the same way line up
+		static Panel FromBars(const std::map<std::string, std::vector<Bar>>& tickerNameToBarsMap) {
+
+			std::map<std::pair<TimestampType, std::string>, ID32> date_numbers;
+			for (const auto& [ticker_name, bars] : tickerNameToBarsMap) {
+				for (const Bar& bar : bars) {
+					date_numbers.emplace(std::pair{ bar.time, bar.date }, 0);
+				}
+			}
+
+			Panel panel;
+			panel.dates.reserve(date_numbers.size());
+			panel.times.reserve(date_numbers.size());
+			for (auto& [key, date_no] : date_numbers) {
+				date_no = static_cast<ID32>(panel.dates.size());
+				panel.times.push_back(key.first);
+				panel.dates.push_back(key.second);
+			}
+
+			const size_t ticker_count = tickerNameToBarsMap.size();
+			const size_t cell_count = date_numbers.size() * ticker_count;
+			for (auto& field : panel.fields) {
+				field.assign(cell_count, std::numeric_limits<MoneyType>::quiet_NaN());
+			}
+			panel.mask.assign(cell_count, 0);
+
+			size_t ticker_no = 0;
+			for (const auto& [ticker_name, bars] : tickerNameToBarsMap) {
+				panel.tickers.push_back(ticker_name);
+				for (const Bar& bar : bars) {
+					const size_t cell = date_numbers.at(std::pair{ bar.time, bar.date }) * ticker_count + ticker_no;
+					panel.fields[static_cast<size_t>(PanelField::Open)][cell]  = bar.open;
+					panel.fields[static_cast<size_t>(PanelField::High)][cell]  = bar.high;
+					panel.fields[static_cast<size_t>(PanelField::Low)][cell]   = bar.low;
+					panel.fields[static_cast<size_t>(PanelField::Close)][cell] = bar.close;
+					panel.mask[cell] = 1;
+				}
+				ticker_no++;
+			}
+			return panel;
+		}
+
+		size_t DateCount() const noexcept {
+			return dates.size();
+		}
+
+		size_t TickerCount() const noexcept {
+			return tickers.size();
+		}
+
+		const std::vector<std::string>& Dates() const noexcept {
+			return dates;
+		}
+
+		const std::vector<TimestampType>& Times() const noexcept {
+			return times;
+		}
+
+		const std::vector<std::string>& Tickers() const noexcept {
+			return tickers;
+		}
+
+		std::optional<ID32> TickerNo(const std::string& tickerName) const noexcept {
+			const auto ticker = std::find(tickers.begin(), tickers.end(), tickerName);
+			if (ticker == tickers.end()) {
+				return std::nullopt;
+			}
+			return static_cast<ID32>(ticker - tickers.begin());
+		}
+
+		// cross section of a field on a date
+		std::span<const MoneyType> Row(const PanelField field, const size_t dateNo) const noexcept {
+			return std::span<const MoneyType>(fields[static_cast<size_t>(field)].data() + dateNo * tickers.size(), tickers.size());
+		}
+
+		std::span<const std::uint8_t> Mask(const size_t dateNo) const noexcept {
+			return std::span<const std::uint8_t>(mask.data() + dateNo * tickers.size(), tickers.size());
+		}
+
+		MoneyType At(const PanelField field, const size_t dateNo, const size_t tickerNo) const noexcept {
+			return fields[static_cast<size_t>(field)][dateNo * tickers.size() + tickerNo];
+		}
+
+		bool IsAvailable(const size_t dateNo, const size_t tickerNo) const noexcept {
+			return mask[dateNo * tickers.size() + tickerNo] != 0;
+		}
+	};
+
+	// Operations over the cross section of one date, missing tickers are skipped and get NaN.
+	struct CrossSection
+	{
+		// 0 for the lowest value up to count - 1 for the highest, ties share their average rank
+		static void Rank(const std::span<const double> values, const std::span<const std::uint8_t> mask, const std::span<double> ranks) {
+
+			std::vector<ID32> order;
+			order.reserve(values.size());
+			for (size_t i = 0; i < values.size(); ++i) {
+				ranks[i] = std::numeric_limits<double>::quiet_NaN();
+				if (IsValid(values, mask, i)) {
+					order.push_back(static_cast<ID32>(i));
+				}
+			}
+			std::sort(order.begin(), order.end(), [&](const ID32 left, const ID32 right) {
+				return values[left] < values[right];
+			});
+
+			for (size_t first = 0; first < order.size(); ) {
+				size_t last = first + 1;
+				while (last < order.size() && values[order[last]] == values[order[first]]) {
+					last++;
+				}
+				const double rank = (first + last - 1) / 2.0;
+				for (size_t i = first; i < last; ++i) {
+					ranks[order[i]] = rank;
+				}
+				first = last;
+			}
+		}
+
+		// (value - mean) / standard deviation of the available values, 0 when they are all equal
+		static void ZScore(const std::span<const double> values, const std::span<const std::uint8_t> mask, const std::span<double> scores) noexcept {
+
+			double count = 0;
+			double sum = 0;
+			double sum_of_squares = 0;
+			for (size_t i = 0; i < values.size(); ++i) {
+				const double weight = IsValid(values, mask, i);
+				const double value = weight != 0 ? values[i] : 0;
+				count += weight;
+				sum += value;
+				sum_of_squares += value * value;
+			}
+
+			const double mean = count != 0 ? sum / count : 0;
+			const double variance = count != 0 ? std::max(0.0, sum_of_squares / count - mean * mean) : 0;
+			const double scale = variance > 0 ? 1 / std::sqrt(variance) : 0;
+
+			for (size_t i = 0; i < values.size(); ++i) {
+				scores[i] = IsValid(values, mask, i) ? (values[i] - mean) * scale : std::numeric_limits<double>::quiet_NaN();
+			}
+		}
+
+		// the n available tickers with the highest values, highest first, ties go to the lower ticker no
+		static std::vector<ID32> TopN(const std::span<const double> values, const std::span<const std::uint8_t> mask, const size_t n) {
+
+			std::vector<ID32> candidates;
+			candidates.reserve(values.size());
+			for (size_t i = 0; i < values.size(); ++i) {
+				if (IsValid(values, mask, i)) {
+					candidates.push_back(static_cast<ID32>(i));
+				}
+			}
+
+			const auto higher = [&](const ID32 left, const ID32 right) {
+				return values[left] != values[right] ? values[left] > values[right] : left < right;
+			};
+			const size_t count = std::min(n, candidates.size());
+			std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), higher);
+			candidates.resize(count);
+			return candidates;
+		}
+
+		// close / close `lookback` dates earlier - 1, NaN when either close is missing
+		static void Momentum(const Panel& panel, const size_t dateNo, const size_t lookback, const std::span<double> momentums) noexcept {
+
+			const auto closes = panel.Row(PanelField::Close, dateNo);
+			if (dateNo < lookback) {
+				std::fill(momentums.begin(), momentums.end(), std::numeric_limits<double>::quiet_NaN());
+				return;
+			}
+			const auto earlier_closes = panel.Row(PanelField::Close, dateNo - lookback);
+			for (size_t i = 0; i < closes.size(); ++i) {
+				momentums[i] = closes[i] / earlier_closes[i] - 1;
+			}
+		}
+
+	private:
+
+		static bool IsValid(const std::span<const double> values, const std::span<const std::uint8_t> mask, const size_t i) noexcept {
+			return mask[i] != 0 && !std::isnan(values[i]);
+		}
+	};
+
+	// Orders of a rotation are per ticker, positionAmount is the holding after the order
+	struct RotationOrderLog
+	{
+		ID32      dateNo{ 0 };
+		ID32      tickerNo{ 0 };
+		MoneyType price{ 0 };
+		ShareType positionAmount{ 0 };
+		OrderType orderType{ OrderType::None };
+	};
+
+	struct RotationSummary
+	{
+		const size_t                                 totalOrders{ 0 };
+		const MoneyType                              finalBalance{ 0 };
+		const std::vector<ParamType>                 params{ };
+		const PerformanceMetrics                     metrics{ };
+		std::optional<std::vector<RotationOrderLog>> orderLogs;
+		std::optional<std::vector<MoneyType>>        dateEndNetWorths;
+	};
+
+	// Passed to the strategy at the close of every date. Setting rebalance moves the portfolio to targetWeights,
+	// fractions of the net worth per ticker, at the close of that date; otherwise the holdings are kept.
+	struct RotationEvent
+	{
+		const Panel&                     panel;
+		const ID32                       dateNo{ 0 };
+		const std::span<const ShareType> positions;
+		const std::span<double>          targetWeights;
+		bool                             rebalance{ false };
+		RandomService&                   randomService;
+	};
+
+	// Drives a portfolio rotation strategy over a panel:
+	//
+	//   std::vector<ParamType> params() const;
+	//   void OnDateClosed(RotationEvent& e);
+	//
+	// Orders fill like single ticker tests, sells at the bid and buys at the ask of the close with the commission,
+	// sells before buys. Tickers without a bar on the date are neither bought nor sold and are valued at their last close.
+	// The final balance is the net worth at the last close, like in Tester::RunTest.
+	struct RotationTester
+	{
+		template <typename StrategyType>
+		static
+		RotationSummary Run(StrategyType&& strategy,
+							const Panel& panel,
+							const MoneyType balance,
+							const CommissionRateType commissionRate,
+							const TestOptions& options = {})
+		{
+			const size_t ticker_count = panel.TickerCount();
+			const CommissionRateType commission_rate = commissionRate / 100;
+
+			MoneyType cash = balance;
+			std::vector<ShareType> positions(ticker_count, 0);
+			std::vector<MoneyType> last_closes(ticker_count, 0);
+			std::vector<MoneyType> entry_prices(ticker_count, 0);
+			std::vector<double> target_weights(ticker_count, 0);
+			RandomService random_service(options.seed, options.runId);
+
+			PerformanceAccumulator performance(balance);
+			std::vector<RotationOrderLog> order_logs;
+			std::vector<MoneyType> date_end_net_worths;
+			size_t total_orders = 0;
+
+			const bool is_recording = options.recordingMode == RecordingMode::Full;
+			if (is_recording) {
+				date_end_net_worths.reserve(panel.DateCount());
+			}
+
+			const auto execute = [&](const ID32 dateNo, const ID32 tickerNo, const ShareType amount, const MoneyType price) {
+
+				const ShareType previous_position = positions[tickerNo];
+				positions[tickerNo] += amount;
+				cash -= amount * price;
+				total_orders++;
+
+				// a round trip of a ticker is one trade, its entry price is the average paid
+				if (amount > 0) {
+					entry_prices[tickerNo] = (entry_prices[tickerNo] * previous_position + price * amount) / positions[tickerNo];
+				}
+				else if (positions[tickerNo] == 0) {
+					performance.OrderExecuted(OrderType::OpenPosition, entry_prices[tickerNo]);
+					performance.OrderExecuted(OrderType::ClosePosition, price);
+				}
+
+				if (is_recording) {
+					order_logs.push_back(RotationOrderLog {
+						.dateNo         = dateNo,
+						.tickerNo       = tickerNo,
+						.price          = price,
+						.positionAmount = positions[tickerNo],
+						.orderType      = amount > 0 ? OrderType::OpenPosition : OrderType::ClosePosition
+					});
+				}
+			};
+
+			for (ID32 date_no = 0; date_no < panel.DateCount(); ++date_no) {
+
+				const auto closes = panel.Row(PanelField::Close, date_no);
+				const auto mask = panel.Mask(date_no);
+
+				for (size_t i = 0; i < ticker_count; ++i) {
+					if (mask[i] != 0) {
+						last_closes[i] = closes[i];
+					}
+				}
+
+				std::fill(target_weights.begin(), target_weights.end(), 0.0);
+				RotationEvent e = { panel, date_no, positions, target_weights, false, random_service };
+				strategy.OnDateClosed(e);
+
+				if (e.rebalance) {
+
+					const MoneyType net_worth = NetWorth(cash, positions, last_closes);
+
+					std::vector<ShareType> targets(ticker_count, 0);
+					for (size_t i = 0; i < ticker_count; ++i) {
+						targets[i] = mask[i] != 0 && closes[i] > 0
+							? static_cast<ShareType>(std::max(0.0, target_weights[i]) * net_worth / closes[i])
+							: positions[i];
+					}
+
+					for (ID32 i = 0; i < ticker_count; ++i) {
+						if (targets[i] < positions[i]) {
+							execute(date_no, i, targets[i] - positions[i], closes[i] * (1 - commission_rate));
+						}
+					}
+					for (ID32 i = 0; i < ticker_count; ++i) {
+						if (targets[i] > positions[i]) {
+							const MoneyType buying_price = (closes[i] + BarUtils::CalculateStep(closes[i])) * (1 + commission_rate);
+							const ShareType amount = std::min<ShareType>(targets[i] - positions[i], static_cast<ShareType>(cash / buying_price));
+							if (amount > 0) {
+								execute(date_no, i, amount, buying_price);
+							}
+						}
+					}
+				}
+
+				const MoneyType net_worth = NetWorth(cash, positions, last_closes);
+				const bool is_exposed = std::any_of(positions.begin(), positions.end(), [](const ShareType position) { return position != 0; });
+				performance.BarClosed(net_worth, is_exposed);
+				if (is_recording) {
+					date_end_net_worths.push_back(net_worth);
+				}
+			}
+
+			return RotationSummary {
+				.totalOrders      = total_orders,
+				.finalBalance     = performance.LastNetWorth(),
+				.params           = strategy.params(),
+				.metrics          = performance.Metrics(options.barsPerYear),
+				.orderLogs        = is_recording ? std::optional{ std::move(order_logs) } : std::nullopt,
+				.dateEndNetWorths = is_recording ? std::optional{ std::move(date_end_net_worths) } : std::nullopt
+			};
+		}
+
+	private:
+
+		static MoneyType NetWorth(const MoneyType cash, const std::vector<ShareType>& positions, const std::vector<MoneyType>& lastCloses) noexcept {
+			MoneyType net_worth = cash;
+			for (size_t i = 0; i < positions.size(); ++i) {
+				net_worth += positions[i] * lastCloses[i];
+			}
+			return net_worth;
+		}
+	};
+
+}
+
+#endif /* panel_h */
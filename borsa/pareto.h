@@ -0,0 +1,203 @@
+//
+//  pareto.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef pareto_h
+#define pareto_h
+
+#include "types.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <map>
+#include <numeric>
+#include <vector>
+
+namespace ba {
+
+	struct ParetoUtils
+	{
+		// the objective oriented so that larger is better, drawdown and order count are negated, NaN is the worst value
+		static double Score(const TestSummary& summary, const Objective objective) noexcept {
+
+			double score = 0;
+			switch (objective) {
+				case Objective::FinalBalance: score = summary.finalBalance; break;
+				case Objective::TotalReturn:  score = summary.metrics.totalReturn; break;
+				case Objective::Cagr:         score = summary.metrics.cagr; break;
+				case Objective::Sharpe:       score = summary.metrics.sharpe; break;
+				case Objective::Sortino:      score = summary.metrics.sortino; break;
+				case Objective::MaxDrawdown:  score = -summary.metrics.maxDrawdown; break;
+				case Objective::WinRate:      score = summary.metrics.winRate; break;
+				case Objective::TotalOrders:  score = -double(summary.totalOrders); break;
+			}
+			return std::isnan(score) ? -std::numeric_limits<double>::infinity() : score;
+		}
+
+		static std::vector<double> Scores(const TestSummary& summary, const std::vector<Objective>& objectives) {
+			std::vector<double> scores;
+			scores.reserve(objectives.size());
+			for (const Objective objective : objectives) {
+				scores.push_back(Score(summary, objective));
+			}
+			return scores;
+		}
+
+		// at least as good in every objective and better in one
+		static bool Dominates(const double* a, const double* b, const size_t objectiveCount) noexcept {
+			bool better = false;
+			for (size_t i = 0; i < objectiveCount; ++i) {
+				if (a[i] < b[i]) {
+					return false;
+				}
+				better |= a[i] > b[i];
+			}
+			return better;
+		}
+
+		// indices of the summaries no other summary dominates, ascending; summaries with equal scores are all kept
+		// after sorting by the scores lexicographically, a dominating summary always comes first, so one pass decides:
+		//   2 objectives: the best second score so far, O(n log n)
+		//   3 objectives: a staircase of the last two scores in a std::map, O(n log n)
+		//   more:         a check against the front found so far, O(n log n + n * front size)
+		static std::vector<size_t> Front(const std::vector<TestSummary>& summaries, const std::vector<Objective>& objectives) {
+
+			const size_t objective_count = objectives.size();
+			if (objective_count == 0) {
+				std::vector<size_t> front(summaries.size());
+				std::iota(front.begin(), front.end(), 0);
+				return front;
+			}
+
+			std::vector<double> scores(summaries.size() * objective_count);
+			for (size_t i = 0; i < summaries.size(); ++i) {
+				for (size_t j = 0; j < objective_count; ++j) {
+					scores[i * objective_count + j] = Score(summaries[i], objectives[j]);
+				}
+			}
+			const auto score = [&](const size_t index) noexcept { return scores.data() + index * objective_count; };
+
+			std::vector<size_t> order(summaries.size());
+			std::iota(order.begin(), order.end(), 0);
+			std::sort(order.begin(), order.end(), [&](const size_t a, const size_t b) {
+				return std::lexicographical_compare(score(b), score(b) + objective_count, score(a), score(a) + objective_count);
+			});
+
+			std::vector<size_t> front;
+			double best_second = -std::numeric_limits<double>::infinity();
+			std::map<double, double> staircase; // second score -> best third score, thirds fall as seconds rise
+
+			const auto is_dominated = [&](const double* candidate) {
+				switch (objective_count) {
+					case 1:
+						return !front.empty() && score(front.front())[0] > candidate[0];
+					case 2:
+						return !front.empty() && best_second >= candidate[1];
+					case 3: {
+						const auto step = staircase.lower_bound(candidate[1]);
+						return step != staircase.end() && step->second >= candidate[2];
+					}
+					default:
+						return std::any_of(front.begin(), front.end(), [&](const size_t member) {
+							return Dominates(score(member), candidate, objective_count);
+						});
+				}
+			};
+
+			const auto add_to_front = [&](const double* member) {
+				if (objective_count == 2) {
+					best_second = std::max(best_second, member[1]);
+				}
+				else if (objective_count == 3) {
+					auto step = staircase.upper_bound(member[1]);
+					while (step != staircase.begin() && std::prev(step)->second <= member[2]) {
+						step = staircase.erase(std::prev(step));
+					}
+					staircase.emplace(member[1], member[2]);
+				}
+			};
+
+			// equal scores are taken as a group, so they do not dominate each other
+			for (size_t first = 0; first < order.size(); ) {
+
+				size_t last = first + 1;
+				while (last < order.size() && std::equal(score(order[first]), score(order[first]) + objective_count, score(order[last]))) {
+					last++;
+				}
+
+				if (!is_dominated(score(order[first]))) {
+					front.insert(front.end(), order.begin() + first, order.begin() + last);
+					add_to_front(score(order[first]));
+				}
+				first = last;
+			}
+
+			std::sort(front.begin(), front.end());
+			return front;
+		}
+	};
+
+	// Keeps only the non-dominated summaries of a sweep whose results arrive one by one, so the rest is never stored.
+	// An offer is compared with the current front, which stays small next to the sweep.
+	class ParetoArchive final
+	{
+	private:
+		std::vector<Objective>         objectives;
+		std::list<std::vector<double>> scores;
+		std::list<TestSummary>         members;
+
+	public:
+
+		explicit ParetoArchive(std::vector<Objective> objectives) noexcept : objectives(std::move(objectives)) { }
+
+		// true when the summary joins the front, members it dominates are dropped
+		bool Offer(TestSummary summary) {
+
+			const size_t objective_count = objectives.size();
+			std::vector<double> offered = ParetoUtils::Scores(summary, objectives);
+
+			for (const auto& member : scores) {
+				if (ParetoUtils::Dominates(member.data(), offered.data(), objective_count)) {
+					return false;
+				}
+			}
+
+			auto member = members.begin();
+			for (auto member_scores = scores.begin(); member_scores != scores.end(); ) {
+				if (ParetoUtils::Dominates(offered.data(), member_scores->data(), objective_count)) {
+					member_scores = scores.erase(member_scores);
+					member = members.erase(member);
+				}
+				else {
+					++member_scores;
+					++member;
+				}
+			}
+
+			scores.push_back(std::move(offered));
+			members.push_back(std::move(summary));
+			return true;
+		}
+
+		const std::list<TestSummary>& Members() const noexcept {
+			return members;
+		}
+
+		const std::vector<Objective>& Objectives() const noexcept {
+			return objectives;
+		}
+
+		size_t size() const noexcept {
+			return members.size();
+		}
+	};
+
+}
+
+#endif /* pareto_h */
@@ -0,0 +1,352 @@
+//
+//  pipeline.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef pipeline_h
+#define pipeline_h
+
+#include "types.h"
+#include "utils.h"
+#include "cache.h"
+#include "tester.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ba {
+
+	// A queue between two stages. Push blocks while it is full, which holds back a stage that runs ahead of the next one.
+	template <typename T>
+	class BoundedQueue final
+	{
+	private:
+		std::mutex              mutex;
+		std::condition_variable notEmpty;
+		std::condition_variable notFull;
+		std::deque<T>           items;
+		const size_t            capacity;
+		size_t                  maxDepth{ 0 };
+		bool                    closed{ false };
+
+	public:
+
+		explicit BoundedQueue(const size_t capacity) noexcept : capacity(std::max<size_t>(1, capacity)) { }
+
+		// false when the queue was closed, the item is dropped
+		bool Push(T item) {
+			std::unique_lock lock(mutex);
+			notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+			if (closed) {
+				return false;
+			}
+			items.push_back(std::move(item));
+			maxDepth = std::max(maxDepth, items.size());
+			notEmpty.notify_one();
+			return true;
+		}
+
+		// nullopt once the queue is closed and drained
+		std::optional<T> Pop() {
+			std::unique_lock lock(mutex);
+			notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+			if (items.empty()) {
+				return std::nullopt;
+			}
+			T item = std::move(items.front());
+			items.pop_front();
+			notFull.notify_one();
+			return item;
+		}
+
+		// items already queued can still be popped
+		void Close() {
+			std::lock_guard lock(mutex);
+			closed = true;
+			notEmpty.notify_all();
+			notFull.notify_all();
+		}
+
+		size_t MaxDepth() {
+			std::lock_guard lock(mutex);
+			return maxDepth;
+		}
+	};
+
+	struct StageStats
+	{
+		std::string              name;
+		size_t                   threadCount{ 0 };
+		std::uint64_t            itemCount{ 0 };
+		std::chrono::nanoseconds busy{ 0 };    // working on items
+		std::chrono::nanoseconds starved{ 0 }; // waiting for the previous stage
+		std::chrono::nanoseconds blocked{ 0 }; // waiting for room in the next stage's queue
+		size_t                   maxQueueDepth{ 0 };
+
+		// fraction of the stage's thread time spent working, the slowest stage is the one close to 1
+		double Utilization(const std::chrono::nanoseconds wallTime) const noexcept {
+			const double available = double(wallTime.count()) * threadCount;
+			return available > 0 ? busy.count() / available : 0;
+		}
+	};
+
+	struct PipelineOptions
+	{
+		size_t loaderCount{ 4 };    // loads are usually waiting on the network
+		size_t simulatorCount{ 0 }; // 0 for one per hardware thread
+		size_t queueCapacity{ 64 };
+	};
+
+	struct PipelineSummary
+	{
+		std::vector<std::vector<double>> gains;      // same matrix as RunTestOnManyStocksForGeneralOptimization, without the row params
+		std::array<StageStats, 3>        stages;     // load, simulate, report
+		std::chrono::nanoseconds         wallTime{ 0 };
+	};
+
+	// Load -> simulate -> report with bounded queues in between, so a ticker is simulated as soon as it is loaded
+	// and results reach the writer while other cells still run. Wall time approaches the slowest stage.
+	//   load:     loaderCount threads call loader(tickerName) and queue a task per row param of the ticker
+	//   simulate: simulatorCount threads run the row of a ticker over every column param
+	//   report:   the calling thread writes every finished row and sums the gain matrix
+	// Rows reach the writer in completion order as [ticker no, row param, gain per column param],
+	// gains are final balance / balance. Runs get the run ids of the grid sweep, so the gains match it
+	// up to the order in which tickers are summed.
+	template <typename StrategyType>
+	class SweepPipeline final
+	{
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct RowTask
+		{
+			size_t                                  tickerNo;
+			size_t                                  rowIndex;
+			std::shared_ptr<const std::vector<Bar>> bars;
+		};
+
+		struct RowResult
+		{
+			size_t              tickerNo;
+			size_t              rowIndex;
+			std::vector<double> gains;
+		};
+
+	public:
+
+		// loader is called as loader(const std::string& tickerName) -> std::vector<Bar> from several threads
+		template <typename Loader, typename ResultWriterType>
+		static
+		PipelineSummary Run(const std::vector<std::string>& tickerNames,
+							Loader&& loader,
+							const std::vector<ParamType>& paramsForRow,
+							const std::vector<ParamType>& paramsForColumn,
+							const MoneyType balance,
+							const CommissionRateType commissionRate,
+							ResultWriterType& writer,
+							const PipelineOptions& pipelineOptions = {})
+		{
+			const auto started_at = Clock::now();
+
+			const size_t loader_count = std::max<size_t>(1, std::min(pipelineOptions.loaderCount, tickerNames.size()));
+			const size_t simulator_count = pipelineOptions.simulatorCount != 0 ? pipelineOptions.simulatorCount : ParallelUtils::DefaultThreadCount();
+
+			BoundedQueue<RowTask> tasks(pipelineOptions.queueCapacity);
+			BoundedQueue<RowResult> results(pipelineOptions.queueCapacity);
+
+			std::array<StageStats, 3> stages{
+				StageStats{ .name = "load", .threadCount = loader_count },
+				StageStats{ .name = "simulate", .threadCount = simulator_count },
+				StageStats{ .name = "report", .threadCount = 1 }
+			};
+			std::mutex stats_mutex;
+
+			std::atomic<size_t> next_ticker{ 0 };
+			std::atomic<size_t> running_loaders{ loader_count };
+			std::atomic<size_t> running_simulators{ simulator_count };
+			std::atomic<bool> failed{ false };
+			std::exception_ptr first_exception;
+
+			const auto fail = [&]() {
+				std::lock_guard lock(stats_mutex);
+				if (!first_exception) {
+					first_exception = std::current_exception();
+				}
+				failed = true;
+				tasks.Close();
+				results.Close();
+			};
+
+			const auto merge = [&](StageStats& stage, const StageStats& local) {
+				std::lock_guard lock(stats_mutex);
+				stage.itemCount += local.itemCount;
+				stage.busy += local.busy;
+				stage.starved += local.starved;
+				stage.blocked += local.blocked;
+			};
+
+			const auto load = [&]() {
+				StageStats local;
+				try {
+					for (size_t ticker_no = next_ticker++; ticker_no < tickerNames.size() && !failed; ticker_no = next_ticker++) {
+
+						const auto loading_at = Clock::now();
+						auto bars = std::make_shared<const std::vector<Bar>>(loader(tickerNames[ticker_no]));
+						const auto loaded_at = Clock::now();
+						local.busy += loaded_at - loading_at;
+						local.itemCount++;
+
+						for (size_t row_index = 0; row_index < paramsForRow.size(); ++row_index) {
+							if (!tasks.Push(RowTask{ ticker_no, row_index, bars })) {
+								break;
+							}
+						}
+						local.blocked += Clock::now() - loaded_at;
+					}
+				}
+				catch (...) {
+					fail();
+				}
+				merge(stages[0], local);
+				if (--running_loaders == 0) {
+					tasks.Close();
+				}
+			};
+
+			const auto simulate = [&]() {
+				StageStats local;
+				try {
+					while (!failed) {
+
+						const auto waiting_at = Clock::now();
+						std::optional<RowTask> task = tasks.Pop();
+						const auto working_at = Clock::now();
+						local.starved += working_at - waiting_at;
+						if (!task) {
+							break;
+						}
+
+						RowResult result{ task->tickerNo, task->rowIndex, SimulateRow(*task, paramsForRow, paramsForColumn, balance, commissionRate) };
+						const auto done_at = Clock::now();
+						local.busy += done_at - working_at;
+						local.itemCount++;
+
+						if (!results.Push(std::move(result))) {
+							break;
+						}
+						local.blocked += Clock::now() - done_at;
+					}
+				}
+				catch (...) {
+					fail();
+				}
+				merge(stages[1], local);
+				if (--running_simulators == 0) {
+					results.Close();
+				}
+			};
+
+			std::vector<std::thread> threads;
+			threads.reserve(loader_count + simulator_count);
+			for (size_t i = 0; i < loader_count; ++i) {
+				threads.emplace_back(load);
+			}
+			for (size_t i = 0; i < simulator_count; ++i) {
+				threads.emplace_back(simulate);
+			}
+
+			PipelineSummary summary;
+			summary.gains.assign(paramsForRow.size(), std::vector<double>(paramsForColumn.size(), 0));
+
+			try {
+				std::vector<std::string> header{ "ticker", "" };
+				for (const ParamType param_for_column : paramsForColumn) {
+					header.push_back(writer.Format(param_for_column));
+				}
+				writer.WriteHeader(header);
+
+				std::vector<double> row;
+				while (true) {
+
+					const auto waiting_at = Clock::now();
+					std::optional<RowResult> result = results.Pop();
+					const auto working_at = Clock::now();
+					stages[2].starved += working_at - waiting_at;
+					if (!result) {
+						break;
+					}
+
+					row.assign({ double(result->tickerNo), paramsForRow[result->rowIndex] });
+					row.insert(row.end(), result->gains.begin(), result->gains.end());
+					writer.WriteRow(row);
+					writer.Flush();
+
+					for (size_t column_index = 0; column_index < paramsForColumn.size(); ++column_index) {
+						summary.gains[result->rowIndex][column_index] += result->gains[column_index] / tickerNames.size();
+					}
+
+					stages[2].busy += Clock::now() - working_at;
+					stages[2].itemCount++;
+				}
+			}
+			catch (...) {
+				fail();
+			}
+
+			for (auto& thread : threads) {
+				thread.join();
+			}
+			if (first_exception) {
+				std::rethrow_exception(first_exception);
+			}
+
+			stages[0].maxQueueDepth = tasks.MaxDepth();
+			stages[1].maxQueueDepth = results.MaxDepth();
+			summary.stages = std::move(stages);
+			summary.wallTime = Clock::now() - started_at;
+			return summary;
+		}
+
+	private:
+
+		static std::vector<double> SimulateRow(const RowTask& task,
+											   const std::vector<ParamType>& paramsForRow,
+											   const std::vector<ParamType>& paramsForColumn,
+											   const MoneyType balance,
+											   const CommissionRateType commissionRate) noexcept
+		{
+			const ParamType param_for_row = paramsForRow[task.rowIndex];
+
+			std::vector<double> gains;
+			gains.reserve(paramsForColumn.size());
+
+			for (const ParamType param_for_column : paramsForColumn) {
+
+				StrategyType strategy(param_for_row, param_for_column);
+
+				const TestOptions options = {
+					.recordingMode = RecordingMode::MetricsOnly,
+					.runId         = Hasher().Add(std::vector<ParamType>{ param_for_row, param_for_column }).Key().low
+				};
+
+				gains.push_back(Tester::RunTest(strategy, *task.bars, balance, commissionRate, options).finalBalance / balance);
+			}
+			return gains;
+		}
+	};
+
+}
+
+#endif /* pipeline_h */
@@ -0,0 +1,146 @@
+//
+//  prepared.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef prepared_h
+#define prepared_h
+
+#include "types.h"
+#include "utils.h"
+#include "resample.h"
+
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+namespace ba {
+
+	struct PrepareOptions
+	{
+		double gapFactor{ 5 }; // a step between bars longer than gapFactor times the median step is a gap
+	};
+
+	// A series checked once and the price columns the tester needs on every bar, which only depend on the data:
+	// the bid is the close, the ask is the close plus its tick step. Every run of a sweep on the same
+	// PreparedSeries shares the columns. The bars must outlive it, as with TimeframeSeries.
+	// Preparing throws for non-positive prices, a high below the low and bars out of time order;
+	// gaps are only reported. Ordering and gaps are checked when every bar has a time or a date TimeUtils can read.
+	class PreparedSeries final
+	{
+	private:
+		const std::vector<Bar>&  bars;
+		const TimeframeSeries*   timeframes{ nullptr };
+		std::vector<MoneyType>   bids;
+		std::vector<MoneyType>   asks;
+		MoneyType                firstBid{ 0 };
+		MoneyType                firstAsk{ 0 };
+		std::vector<size_t>      gaps;
+
+	public:
+
+		explicit PreparedSeries(const std::vector<Bar>& bars, const PrepareOptions& options = {}) : bars(bars) {
+			Validate(options);
+			BuildColumns();
+		}
+
+		// keeps the higher timeframes of the series available to strategies
+		explicit PreparedSeries(const TimeframeSeries& series, const PrepareOptions& options = {}) : PreparedSeries(series.Base(), options) {
+			timeframes = &series;
+		}
+
+		explicit PreparedSeries(std::vector<Bar>&&, const PrepareOptions& = {}) = delete;
+
+		PreparedSeries(const PreparedSeries&) = delete;
+		PreparedSeries& operator=(const PreparedSeries&) = delete;
+
+		const std::vector<Bar>& Bars() const noexcept { return bars; }
+		const TimeframeSeries* Timeframes() const noexcept { return timeframes; }
+		size_t size() const noexcept { return bars.size(); }
+		bool empty() const noexcept { return bars.empty(); }
+
+		std::span<const MoneyType> Bids() const noexcept { return bids; }
+		std::span<const MoneyType> Asks() const noexcept { return asks; }
+
+		// prices of OnStart, taken at the open of the first bar; OnStop uses the close of the last bar, bids.back()
+		MoneyType FirstBid() const noexcept { return firstBid; }
+		MoneyType FirstAsk() const noexcept { return firstAsk; }
+
+		// numbers of the bars that come after a gap
+		const std::vector<size_t>& Gaps() const noexcept { return gaps; }
+
+	private:
+
+		void BuildColumns() {
+
+			bids.reserve(bars.size());
+			asks.reserve(bars.size());
+
+			for (const Bar& bar : bars) {
+				bids.push_back(bar.close);
+				asks.push_back(bar.close + BarUtils::CalculateStep(bar.close));
+			}
+
+			if (!bars.empty()) {
+				firstBid = bars.front().open;
+				firstAsk = firstBid + BarUtils::CalculateStep(firstBid);
+			}
+		}
+
+		void Validate(const PrepareOptions& options) {
+
+			std::vector<TimestampType> times;
+			times.reserve(bars.size());
+
+			for (size_t bar_no = 0; bar_no < bars.size(); ++bar_no) {
+
+				const Bar& bar = bars[bar_no];
+				if (!(bar.open > 0 && bar.high > 0 && bar.low > 0 && bar.close > 0)) {
+					throw std::invalid_argument("bar " + std::to_string(bar_no) + " has a price that is not positive");
+				}
+				if (bar.high < bar.low) {
+					throw std::invalid_argument("bar " + std::to_string(bar_no) + " has a high below its low");
+				}
+
+				const std::optional<TimestampType> time = bar.time != 0 ? std::optional{ bar.time } : TimeUtils::TimestampFromString(bar.date);
+				if (time) {
+					times.push_back(*time);
+				}
+			}
+
+			if (times.size() != bars.size()) {
+				return;
+			}
+
+			std::vector<TimestampType> differences;
+			differences.reserve(times.size());
+			for (size_t bar_no = 1; bar_no < times.size(); ++bar_no) {
+				if (times[bar_no] <= times[bar_no - 1]) {
+					throw std::invalid_argument("bar " + std::to_string(bar_no) + " is not after the bar before it");
+				}
+				differences.push_back(times[bar_no] - times[bar_no - 1]);
+			}
+			if (differences.empty()) {
+				return;
+			}
+
+			std::vector<TimestampType> sorted = differences;
+			std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+			const double longest_step = sorted[sorted.size() / 2] * options.gapFactor;
+
+			for (size_t i = 0; i < differences.size(); ++i) {
+				if (differences[i] > longest_step) {
+					gaps.push_back(i + 1);
+				}
+			}
+		}
+	};
+
+}
+
+#endif /* prepared_h */
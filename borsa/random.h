@@ -0,0 +1,77 @@
+//
+//  random.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef random_h
+#define random_h
+
+#include <cstdint>
+
+namespace ba {
+
+	// Counter based generator: the n-th value is a SplitMix64 hash of (key, n), the key being derived from (seed, runId).
+	// A run owns its service, so results depend only on the seed and run id, never on threads or scheduling.
+	class RandomService final
+	{
+	private:
+		static constexpr std::uint64_t GOLDEN_GAMMA{ 0x9E3779B97F4A7C15ull };
+
+		std::uint64_t key{ 0 };
+		std::uint64_t counter{ 0 };
+
+	public:
+
+		explicit RandomService(const std::uint64_t seed = 0, const std::uint64_t runId = 0) noexcept
+		: key(Mix(Mix(seed + GOLDEN_GAMMA) ^ Mix(runId * GOLDEN_GAMMA + 1)))
+		{ }
+
+		static constexpr std::uint64_t Mix(std::uint64_t z) noexcept {
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		// value at an arbitrary position of the stream, does not advance it
+		std::uint64_t At(const std::uint64_t position) const noexcept {
+			return Mix(key + GOLDEN_GAMMA * (position + 1));
+		}
+
+		std::uint64_t Next() noexcept {
+			return At(counter++);
+		}
+
+		// uniform in [0, 1)
+		double NextDouble() noexcept {
+			return (Next() >> 11) * 0x1.0p-53;
+		}
+
+		// uniform in [0, bound), bound must not be zero
+		std::uint64_t NextBelow(const std::uint64_t bound) noexcept {
+			const std::uint64_t threshold = (0 - bound) % bound;
+			while (true) {
+				const std::uint64_t value = Next();
+				if (value >= threshold) {
+					return value % bound;
+				}
+			}
+		}
+
+		bool NextBool() noexcept {
+			return (Next() >> 63) != 0;
+		}
+
+		std::uint64_t Position() const noexcept {
+			return counter;
+		}
+
+		void Seek(const std::uint64_t position) noexcept {
+			counter = position;
+		}
+	};
+
+}
+
+#endif /* random_h */
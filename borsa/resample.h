@@ -0,0 +1,183 @@
+//
+//  resample.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef resample_h
+#define resample_h
+
+#include "types.h"
+#include "utils.h"
+
+#include <array>
+#include <charconv>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ba {
+
+	// Higher timeframe bars of a base series. An aggregated bar is dated by its first base bar.
+	struct ResampledSeries
+	{
+		std::vector<Bar>       bars;
+		std::vector<ID32>      groupOfBar;  // base bar no -> aggregated bar no
+		std::vector<MoneyType> runningHigh; // high of the aggregated bar up to the base bar
+		std::vector<MoneyType> runningLow;  // low of the aggregated bar up to the base bar
+	};
+
+	struct ResampleUtils
+	{
+		// dates are "YYYY-MM-DD" optionally followed by " HH" or "THH", consecutive base bars with equal keys form one bar
+		static std::int64_t TimeframeKey(const std::string& date, const Timeframe timeframe) noexcept {
+
+			const int year  = ParseNumber(date, 0, 4);
+			const int month = ParseNumber(date, 5, 2);
+			const int day   = ParseNumber(date, 8, 2);
+			const std::int64_t days = TimeUtils::DaysFromCivil(year, month, day);
+
+			switch (timeframe) {
+				case Timeframe::Hourly:
+					return days * 24 + ParseNumber(date, 11, 2);
+				case Timeframe::Daily:
+					return days;
+				case Timeframe::Weekly:
+					// 1970-01-05, day 4, is a monday
+					return FloorDivide(days - 4, 7);
+				case Timeframe::Monthly:
+					return std::int64_t(year) * 12 + month - 1;
+			}
+			return days;
+		}
+
+		static std::int64_t TimeframeKey(const TimestampType time, const Timeframe timeframe) noexcept {
+
+			const std::int64_t days = FloorDivide(time, 86400);
+
+			switch (timeframe) {
+				case Timeframe::Hourly:
+					return FloorDivide(time, 3600);
+				case Timeframe::Daily:
+					return days;
+				case Timeframe::Weekly:
+					return FloorDivide(days - 4, 7);
+				case Timeframe::Monthly: {
+					const auto date = TimeUtils::CivilFromDays(days);
+					return std::int64_t(date.year) * 12 + date.month - 1;
+				}
+			}
+			return days;
+		}
+
+		// bars with a timestamp are grouped by it, others by their date string
+		static std::int64_t TimeframeKey(const Bar& bar, const Timeframe timeframe) noexcept {
+			return bar.time != 0 ? TimeframeKey(bar.time, timeframe) : TimeframeKey(bar.date, timeframe);
+		}
+
+		static ResampledSeries Resample(const std::vector<Bar>& bars, const Timeframe timeframe) {
+
+			ResampledSeries series;
+			series.groupOfBar.reserve(bars.size());
+			series.runningHigh.reserve(bars.size());
+			series.runningLow.reserve(bars.size());
+
+			std::int64_t current_key = 0;
+
+			for (const Bar& bar : bars) {
+
+				const std::int64_t key = TimeframeKey(bar, timeframe);
+
+				if (series.bars.empty() || key != current_key) {
+					current_key = key;
+					series.bars.push_back(bar);
+				}
+				else {
+					Bar& aggregated = series.bars.back();
+					aggregated.high  = std::max(aggregated.high, bar.high);
+					aggregated.low   = std::min(aggregated.low, bar.low);
+					aggregated.close = bar.close;
+				}
+
+				series.groupOfBar.push_back(static_cast<ID32>(series.bars.size() - 1));
+				series.runningHigh.push_back(series.bars.back().high);
+				series.runningLow.push_back(series.bars.back().low);
+			}
+
+			return series;
+		}
+
+	private:
+
+		static int ParseNumber(const std::string& text, const size_t position, const size_t length) noexcept {
+			int value = 0;
+			if (position + length <= text.size()) {
+				std::from_chars(text.data() + position, text.data() + position + length, value);
+			}
+			return value;
+		}
+
+		static std::int64_t FloorDivide(const std::int64_t value, const std::int64_t divisor) noexcept {
+			return value / divisor - (value % divisor < 0);
+		}
+	};
+
+	// A base series with its higher timeframes, every timeframe is built on first use and then shared.
+	// Tests running on the same TimeframeSeries (a whole sweep) never resample twice.
+	// Bars a strategy can see at base bar n:
+	//   Completed(timeframe, n): aggregated bars that ended before the one containing bar n
+	//   Current(timeframe, n):   the aggregated bar containing bar n, built from bars up to n only
+	class TimeframeSeries final
+	{
+	private:
+		static constexpr size_t TIMEFRAME_COUNT = 4;
+
+		const std::vector<Bar>& base;
+		mutable std::array<std::once_flag, TIMEFRAME_COUNT> builtFlags;
+		mutable std::array<std::optional<ResampledSeries>, TIMEFRAME_COUNT> resampled;
+
+	public:
+
+		explicit TimeframeSeries(const std::vector<Bar>& base) noexcept : base(base) { }
+		explicit TimeframeSeries(std::vector<Bar>&&) = delete;
+
+		TimeframeSeries(const TimeframeSeries&) = delete;
+		TimeframeSeries& operator=(const TimeframeSeries&) = delete;
+
+		const std::vector<Bar>& Base() const noexcept {
+			return base;
+		}
+
+		const ResampledSeries& Get(const Timeframe timeframe) const {
+			const size_t index = static_cast<size_t>(timeframe);
+			std::call_once(builtFlags[index], [&]() {
+				resampled[index] = ResampleUtils::Resample(base, timeframe);
+			});
+			return *resampled[index];
+		}
+
+		std::span<const Bar> Completed(const Timeframe timeframe, const ID32 barNo) const {
+			const ResampledSeries& series = Get(timeframe);
+			return std::span<const Bar>(series.bars.data(), series.groupOfBar.at(barNo));
+		}
+
+		Bar Current(const Timeframe timeframe, const ID32 barNo) const {
+			const ResampledSeries& series = Get(timeframe);
+			const Bar& aggregated = series.bars[series.groupOfBar.at(barNo)];
+			return Bar {
+				.date  = aggregated.date,
+				.open  = aggregated.open,
+				.high  = series.runningHigh[barNo],
+				.low   = series.runningLow[barNo],
+				.close = base[barNo].close,
+				.time  = aggregated.time
+			};
+		}
+	};
+
+}
+
+#endif /* resample_h */
@@ -0,0 +1,451 @@
+//
+//  rules.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef rules_h
+#define rules_h
+
+#include "types.h"
+
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ba {
+
+	// a series stored column by column, rules are evaluated over these
+	struct BarColumns
+	{
+		std::vector<MoneyType> open;
+		std::vector<MoneyType> high;
+		std::vector<MoneyType> low;
+		std::vector<MoneyType> close;
+
+		size_t size() const noexcept {
+			return close.size();
+		}
+
+		static BarColumns FromBars(const std::vector<Bar>& bars) {
+			BarColumns columns;
+			columns.open.reserve(bars.size());
+			columns.high.reserve(bars.size());
+			columns.low.reserve(bars.size());
+			columns.close.reserve(bars.size());
+			for (const Bar& bar : bars) {
+				columns.open.push_back(bar.open);
+				columns.high.push_back(bar.high);
+				columns.low.push_back(bar.low);
+				columns.close.push_back(bar.close);
+			}
+			return columns;
+		}
+	};
+
+	// Entry and exit rules written as expressions over columns, e.g.
+	//
+	//   using ba::rules::close;
+	//   const auto entry = close > rules::sma(20) && rules::rsi(14) < 30;
+	//
+	// An expression is a tree of types. Bind() resolves it against a series, computing indicator columns once,
+	// and Evaluate() runs the bound tree in one loop over the bars that the compiler inlines and vectorizes.
+	// Values before an indicator has enough bars are NaN, so every comparison with them is false.
+	// Columns are qualified or brought in with using-declarations, `close` and `open` also name POSIX functions.
+	namespace rules {
+
+		struct ExpressionTag { };
+
+		template <typename T>
+		concept Expression = std::derived_from<std::remove_cvref_t<T>, ExpressionTag>;
+
+		template <typename T>
+		concept Operand = Expression<T> || std::is_arithmetic_v<std::remove_cvref_t<T>>;
+
+		// bound nodes, called with a bar no
+
+		struct BoundColumn
+		{
+			const MoneyType* values;
+			MoneyType operator()(const size_t i) const noexcept { return values[i]; }
+		};
+
+		struct BoundConstant
+		{
+			double value;
+			double operator()(const size_t) const noexcept { return value; }
+		};
+
+		struct BoundComputed
+		{
+			std::vector<double> values;
+			double operator()(const size_t i) const noexcept { return values[i]; }
+		};
+
+		template <typename Operation, typename Left, typename Right>
+		struct BoundBinary
+		{
+			Operation operation;
+			Left      left;
+			Right     right;
+			auto operator()(const size_t i) const noexcept { return operation(left(i), right(i)); }
+		};
+
+		template <typename Operation, typename Inner>
+		struct BoundUnary
+		{
+			Operation operation;
+			Inner     operand;
+			auto operator()(const size_t i) const noexcept { return operation(operand(i)); }
+		};
+
+		// logical operators evaluate both sides, which keeps the loop free of branches
+		struct And
+		{
+			bool operator()(const bool left, const bool right) const noexcept { return left & right; }
+		};
+
+		struct Or
+		{
+			bool operator()(const bool left, const bool right) const noexcept { return left | right; }
+		};
+
+		struct Not
+		{
+			bool operator()(const bool operand) const noexcept { return !operand; }
+		};
+
+		// evaluates a bound numeric node into a column, used by nodes that need a whole column of their input
+		template <typename Bound>
+		std::vector<double> Materialize(const Bound& bound, const size_t size) {
+			std::vector<double> values(size);
+			for (size_t i = 0; i < size; ++i) {
+				values[i] = bound(i);
+			}
+			return values;
+		}
+
+		inline constexpr double NOT_AVAILABLE = std::numeric_limits<double>::quiet_NaN();
+
+		// index of the first finite value, an indicator of an indicator starts where its input becomes available
+		inline size_t FirstAvailable(const std::vector<double>& values) noexcept {
+			size_t first = 0;
+			while (first < values.size() && !std::isfinite(values[first])) {
+				++first;
+			}
+			return first;
+		}
+
+		// expression nodes
+
+		struct Column : ExpressionTag
+		{
+			std::vector<MoneyType> BarColumns::* member;
+
+			BoundColumn Bind(const BarColumns& columns) const noexcept {
+				return BoundColumn{ (columns.*member).data() };
+			}
+		};
+
+		struct Constant : ExpressionTag
+		{
+			double value;
+
+			BoundConstant Bind(const BarColumns&) const noexcept {
+				return BoundConstant{ value };
+			}
+		};
+
+		template <typename Operation, Expression Left, Expression Right>
+		struct Binary : ExpressionTag
+		{
+			Left  left;
+			Right right;
+
+			Binary(Left left, Right right) : left(std::move(left)), right(std::move(right)) { }
+
+			auto Bind(const BarColumns& columns) const {
+				using BoundLeft = decltype(left.Bind(columns));
+				using BoundRight = decltype(right.Bind(columns));
+				return BoundBinary<Operation, BoundLeft, BoundRight>{ Operation{}, left.Bind(columns), right.Bind(columns) };
+			}
+		};
+
+		template <typename Operation, Expression Inner>
+		struct Unary : ExpressionTag
+		{
+			Inner operand;
+
+			explicit Unary(Inner operand) : operand(std::move(operand)) { }
+
+			auto Bind(const BarColumns& columns) const {
+				using BoundOperand = decltype(operand.Bind(columns));
+				return BoundUnary<Operation, BoundOperand>{ Operation{}, operand.Bind(columns) };
+			}
+		};
+
+		// value of the source `count` bars ago
+		template <Expression Source>
+		struct Shift : ExpressionTag
+		{
+			Source source;
+			size_t count;
+
+			Shift(Source source, const size_t count) : source(std::move(source)), count(count) { }
+
+			BoundComputed Bind(const BarColumns& columns) const {
+				const std::vector<double> input = Materialize(source.Bind(columns), columns.size());
+				std::vector<double> values(input.size(), NOT_AVAILABLE);
+				for (size_t i = count; i < input.size(); ++i) {
+					values[i] = input[i - count];
+				}
+				return BoundComputed{ std::move(values) };
+			}
+		};
+
+		template <Expression Source>
+		struct Sma : ExpressionTag
+		{
+			Source source;
+			size_t period;
+
+			Sma(Source source, const size_t period) : source(std::move(source)), period(std::max<size_t>(1, period)) { }
+
+			BoundComputed Bind(const BarColumns& columns) const {
+				const std::vector<double> input = Materialize(source.Bind(columns), columns.size());
+				std::vector<double> values(input.size(), NOT_AVAILABLE);
+				const size_t first = FirstAvailable(input);
+				double sum = 0;
+				for (size_t i = first; i < input.size(); ++i) {
+					sum += input[i];
+					if (i >= first + period) {
+						sum -= input[i - period];
+					}
+					if (i + 1 >= first + period) {
+						values[i] = sum / period;
+					}
+				}
+				return BoundComputed{ std::move(values) };
+			}
+		};
+
+		// seeded with the simple average of the first `period` available values
+		template <Expression Source>
+		struct Ema : ExpressionTag
+		{
+			Source source;
+			size_t period;
+
+			Ema(Source source, const size_t period) : source(std::move(source)), period(std::max<size_t>(1, period)) { }
+
+			BoundComputed Bind(const BarColumns& columns) const {
+				const std::vector<double> input = Materialize(source.Bind(columns), columns.size());
+				std::vector<double> values(input.size(), NOT_AVAILABLE);
+				const double alpha = 2.0 / (period + 1);
+				const size_t first = FirstAvailable(input);
+				double average = 0;
+				for (size_t i = first; i < input.size(); ++i) {
+					if (i < first + period) {
+						average += input[i] / period;
+					}
+					else {
+						average += alpha * (input[i] - average);
+					}
+					if (i + 1 >= first + period) {
+						values[i] = average;
+					}
+				}
+				return BoundComputed{ std::move(values) };
+			}
+		};
+
+		// Wilder's relative strength index in [0, 100]
+		template <Expression Source>
+		struct Rsi : ExpressionTag
+		{
+			Source source;
+			size_t period;
+
+			Rsi(Source source, const size_t period) : source(std::move(source)), period(std::max<size_t>(1, period)) { }
+
+			BoundComputed Bind(const BarColumns& columns) const {
+				const std::vector<double> input = Materialize(source.Bind(columns), columns.size());
+				std::vector<double> values(input.size(), NOT_AVAILABLE);
+				const size_t first = FirstAvailable(input);
+				double average_gain = 0;
+				double average_loss = 0;
+				for (size_t i = first + 1; i < input.size(); ++i) {
+					const double change = input[i] - input[i - 1];
+					const double gain = std::max(0.0, change);
+					const double loss = std::max(0.0, -change);
+					if (i <= first + period) {
+						average_gain += gain / period;
+						average_loss += loss / period;
+					}
+					else {
+						average_gain = (average_gain * (period - 1) + gain) / period;
+						average_loss = (average_loss * (period - 1) + loss) / period;
+					}
+					if (i >= first + period) {
+						values[i] = average_loss == 0 ? 100 : 100 - 100 / (1 + average_gain / average_loss);
+					}
+				}
+				return BoundComputed{ std::move(values) };
+			}
+		};
+
+		inline const Column open{ {}, &BarColumns::open };
+		inline const Column high{ {}, &BarColumns::high };
+		inline const Column low{ {}, &BarColumns::low };
+		inline const Column close{ {}, &BarColumns::close };
+
+		template <Operand T>
+		auto AsExpression(T&& value) {
+			if constexpr (Expression<T>) {
+				return std::remove_cvref_t<T>(std::forward<T>(value));
+			}
+			else {
+				return Constant{ {}, static_cast<double>(value) };
+			}
+		}
+
+		template <Expression Source>
+		auto shift(Source source, const size_t count) { return Shift<Source>(std::move(source), count); }
+
+		template <Expression Source>
+		auto sma(Source source, const size_t period) { return Sma<Source>(std::move(source), period); }
+		inline auto sma(const size_t period) { return sma(close, period); }
+
+		template <Expression Source>
+		auto ema(Source source, const size_t period) { return Ema<Source>(std::move(source), period); }
+		inline auto ema(const size_t period) { return ema(close, period); }
+
+		template <Expression Source>
+		auto rsi(Source source, const size_t period) { return Rsi<Source>(std::move(source), period); }
+		inline auto rsi(const size_t period) { return rsi(close, period); }
+
+		template <typename Operation, Operand Left, Operand Right>
+		requires (Expression<Left> || Expression<Right>)
+		auto MakeBinary(Left&& left, Right&& right) {
+			auto left_expression = AsExpression(std::forward<Left>(left));
+			auto right_expression = AsExpression(std::forward<Right>(right));
+			return Binary<Operation, decltype(left_expression), decltype(right_expression)>(std::move(left_expression), std::move(right_expression));
+		}
+
+#define BA_RULE_OPERATOR(symbol, operation) \
+		template <Operand Left, Operand Right> \
+		requires (Expression<Left> || Expression<Right>) \
+		auto operator symbol(Left&& left, Right&& right) { \
+			return MakeBinary<operation>(std::forward<Left>(left), std::forward<Right>(right)); \
+		}
+
+		BA_RULE_OPERATOR(+,  std::plus<>)
+		BA_RULE_OPERATOR(-,  std::minus<>)
+		BA_RULE_OPERATOR(*,  std::multiplies<>)
+		BA_RULE_OPERATOR(/,  std::divides<>)
+		BA_RULE_OPERATOR(<,  std::less<>)
+		BA_RULE_OPERATOR(>,  std::greater<>)
+		BA_RULE_OPERATOR(<=, std::less_equal<>)
+		BA_RULE_OPERATOR(>=, std::greater_equal<>)
+		BA_RULE_OPERATOR(==, std::equal_to<>)
+		BA_RULE_OPERATOR(!=, std::not_equal_to<>)
+		BA_RULE_OPERATOR(&&, And)
+		BA_RULE_OPERATOR(||, Or)
+
+#undef BA_RULE_OPERATOR
+
+		template <Expression Inner>
+		auto operator!(Inner&& operand) {
+			return Unary<Not, std::remove_cvref_t<Inner>>(std::forward<Inner>(operand));
+		}
+
+		template <Expression Inner>
+		auto operator-(Inner&& operand) {
+			return Unary<std::negate<>, std::remove_cvref_t<Inner>>(std::forward<Inner>(operand));
+		}
+
+		// one fused pass over the bars, rules give 0/1 bytes and numeric expressions give doubles
+		template <Expression E>
+		auto Evaluate(const E& expression, const BarColumns& columns) {
+
+			const auto bound = expression.Bind(columns);
+			using ValueType = decltype(bound(0));
+			using StoredType = std::conditional_t<std::is_same_v<ValueType, bool>, std::uint8_t, double>;
+
+			std::vector<StoredType> values(columns.size());
+			for (size_t i = 0; i < values.size(); ++i) {
+				values[i] = static_cast<StoredType>(bound(i));
+			}
+			return values;
+		}
+	}
+
+	// Position tracking for compiled rules: opens on an entry signal while closed and closes on an exit signal while opened.
+	// Signals are looked up by bar no, so the strategy runs on the series it was compiled for, through Tester::RunTest.
+	class SignalStrategy final
+	{
+	private:
+		std::shared_ptr<const std::vector<std::uint8_t>> entries;
+		std::shared_ptr<const std::vector<std::uint8_t>> exits;
+		std::vector<ParamType> parameters;
+
+	public:
+
+		SignalStrategy(std::vector<std::uint8_t> entries, std::vector<std::uint8_t> exits, std::vector<ParamType> params = {})
+		: entries(std::make_shared<const std::vector<std::uint8_t>>(std::move(entries)))
+		, exits(std::make_shared<const std::vector<std::uint8_t>>(std::move(exits)))
+		, parameters(std::move(params))
+		{ }
+
+		// params are reported in summaries, pass the ones the rules were built from
+		template <rules::Expression Entry, rules::Expression Exit>
+		static SignalStrategy Compile(const Entry& entry, const Exit& exit, const BarColumns& columns, std::vector<ParamType> params = {}) {
+			return SignalStrategy(rules::Evaluate(entry, columns), rules::Evaluate(exit, columns), std::move(params));
+		}
+
+		std::vector<ParamType> params() const noexcept {
+			return parameters;
+		}
+
+		void OnStart(StartEvent&) noexcept {
+		}
+
+		void OnBarClosed(BarClosedEvent& e) noexcept {
+
+			if (e.barNo >= entries->size()) {
+				return;
+			}
+
+			switch (e.positionType) {
+				case PositionType::Closed:
+					if ((*entries)[e.barNo]) {
+						e.orderService.OpenPosition();
+					}
+					break;
+				case PositionType::Opened:
+					if ((*exits)[e.barNo]) {
+						e.orderService.ClosePosition();
+					}
+					break;
+			}
+		}
+
+		void OnStop(StopEvent&) noexcept {
+		}
+
+		// signals are constant and the position is tracked by the tester
+		template<typename Archive>
+		void Serialize(Archive&) {
+		}
+	};
+
+}
+
+#endif /* rules_h */
@@ -0,0 +1,328 @@
+//
+//  shard.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef shard_h
+#define shard_h
+
+#include "types.h"
+#include "utils.h"
+#include "checkpoint.h"
+#include "cache.h"
+#include "tester.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string>
+#include <stdexcept>
+#include <tuple>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ba {
+
+	// Shard file layout, native endianness:
+	//   "BASH" | uint32 version | sweep key | uint64 shard no | uint64 first | uint64 last
+	//   then for every permutation in [first, last): uint64 total orders | double final balance | PerformanceMetrics
+	// A shard file only exists once the shard is complete, so any process can tell which shards are left.
+	struct ShardFormat
+	{
+		static constexpr char          MAGIC[4]{ 'B', 'A', 'S', 'H' };
+		static constexpr std::uint32_t VERSION{ 1 };
+	};
+
+	// Splits a permutation sweep into shards that run in separate processes, on this machine or on other nodes
+	// sharing the directory, and merges their outputs into what RunTestUsingParamPermutations would return.
+	// Every process constructs the sweep from the same inputs; a hash of them is stored in the shard files
+	// so outputs of a different sweep left in the directory are never merged.
+	// Runs are MetricsOnly, merged summaries carry params and metrics but no logs.
+	template <typename StrategyType>
+	class ShardedSweep final
+	{
+	private:
+		const std::vector<std::vector<ParamType>>& paramPermutations;
+		const std::vector<Bar>& bars;
+		const MoneyType balance;
+		const CommissionRateType commissionRate;
+		const TestOptions options;
+		const std::string directory;
+		const size_t shardCount;
+		const ResultKey sweepKey;
+
+	public:
+
+		ShardedSweep(const std::vector<std::vector<ParamType>>& paramPermutations,
+					 const std::vector<Bar>& bars,
+					 const MoneyType balance,
+					 const CommissionRateType commissionRate,
+					 const std::string& directory,
+					 const size_t shardCount,
+					 const TestOptions& options = {})
+		: paramPermutations(paramPermutations)
+		, bars(bars)
+		, balance(balance)
+		, commissionRate(commissionRate)
+		, options(WithMetricsOnly(options))
+		, directory(directory)
+		, shardCount(std::max<size_t>(1, shardCount))
+		, sweepKey(MakeSweepKey(paramPermutations, bars, balance, commissionRate, this->options, this->shardCount))
+		{ }
+
+		size_t ShardCount() const noexcept {
+			return shardCount;
+		}
+
+		// permutations [first, last) belong to the shard, sizes differ by at most one
+		std::pair<size_t, size_t> ShardRange(const size_t shardNo) const noexcept {
+			const size_t count = paramPermutations.size();
+			return { count * shardNo / shardCount, count * (shardNo + 1) / shardCount };
+		}
+
+		std::string ShardFileName(const size_t shardNo) const {
+			return directory + "/shard-" + std::to_string(shardNo) + ".bin";
+		}
+
+		bool IsShardDone(const size_t shardNo) const {
+			std::ifstream in(ShardFileName(shardNo), std::ios::binary);
+			if (!in) {
+				return false;
+			}
+			try {
+				ReadShard(in, shardNo);
+				return true;
+			}
+			catch (const std::exception&) {
+				return false;
+			}
+		}
+
+		std::vector<size_t> PendingShards() const {
+			std::vector<size_t> pending;
+			for (size_t shard_no = 0; shard_no < shardCount; ++shard_no) {
+				if (!IsShardDone(shard_no)) {
+					pending.push_back(shard_no);
+				}
+			}
+			return pending;
+		}
+
+		// runs one shard in this process, worker processes on other nodes call this with their shard no
+		void RunShard(const size_t shardNo) const {
+
+			if (shardNo >= shardCount) {
+				throw std::out_of_range("no shard " + std::to_string(shardNo));
+			}
+
+			const auto [first, last] = ShardRange(shardNo);
+			const std::vector<std::vector<ParamType>> shard_permutations(paramPermutations.begin() + first, paramPermutations.begin() + last);
+
+			const std::vector<TestSummary> summaries = Tester::RunTestUsingParamPermutations<StrategyType>(
+				shard_permutations, bars, balance, commissionRate, options);
+
+			const std::string file_name = ShardFileName(shardNo);
+			const std::string temporary_file_name = file_name + ".tmp." + std::to_string(getpid());
+			{
+				std::ofstream out(temporary_file_name, std::ios::binary | std::ios::trunc);
+				CheckpointWriter archive(out);
+				archive(ShardFormat::MAGIC, ShardFormat::VERSION, sweepKey,
+						std::uint64_t(shardNo), std::uint64_t(first), std::uint64_t(last));
+				for (const TestSummary& summary : summaries) {
+					archive(std::uint64_t(summary.totalOrders), summary.finalBalance, summary.metrics);
+				}
+			}
+			// the shard is visible only once it is complete
+			if (std::rename(temporary_file_name.c_str(), file_name.c_str()) != 0) {
+				std::remove(temporary_file_name.c_str());
+				throw std::runtime_error("could not write " + file_name);
+			}
+		}
+
+		// forks up to processCount workers at a time for the shards that are not done yet,
+		// a failed shard is restarted until it has been tried maxAttempts times
+		void RunLocally(const size_t processCount = 0, const size_t maxAttempts = 3) const {
+
+			const size_t worker_count = processCount != 0 ? processCount : ParallelUtils::DefaultThreadCount();
+
+			std::deque<size_t> queue;
+			for (const size_t shard_no : PendingShards()) {
+				queue.push_back(shard_no);
+			}
+
+			std::map<pid_t, size_t> running;
+			std::map<size_t, size_t> attempts;
+			std::vector<size_t> failed;
+
+			while (!queue.empty() || !running.empty()) {
+
+				while (!queue.empty() && running.size() < worker_count) {
+
+					const size_t shard_no = queue.front();
+					queue.pop_front();
+					attempts[shard_no]++;
+
+					const pid_t pid = fork();
+					if (pid < 0) {
+						throw std::runtime_error("could not start a worker process");
+					}
+					if (pid == 0) {
+						// nothing may unwind into the parent's frames, the child would go on running its loop
+						int status = 0;
+						try {
+							RunShard(shard_no);
+						}
+						catch (...) {
+							status = 1;
+						}
+						_exit(status);
+					}
+					running[pid] = shard_no;
+				}
+
+				int status = 0;
+				const pid_t pid = waitpid(-1, &status, 0);
+				if (pid < 0) {
+					throw std::runtime_error("lost track of worker processes");
+				}
+
+				const auto worker = running.find(pid);
+				if (worker == running.end()) {
+					continue;
+				}
+				const size_t shard_no = worker->second;
+				running.erase(worker);
+
+				const bool succeeded = WIFEXITED(status) && WEXITSTATUS(status) == 0 && IsShardDone(shard_no);
+				if (!succeeded) {
+					if (attempts[shard_no] < maxAttempts) {
+						queue.push_back(shard_no);
+					}
+					else {
+						failed.push_back(shard_no);
+					}
+				}
+			}
+
+			if (!failed.empty()) {
+				throw std::runtime_error(std::to_string(failed.size()) + " shards failed, first is " + std::to_string(failed.front()));
+			}
+		}
+
+		// summaries in permutation order, throws when a shard is missing
+		// params are reported by the strategy like in RunTestUsingParamPermutations
+		std::vector<TestSummary> Merge() const {
+
+			std::vector<TestSummary> summaries;
+			summaries.reserve(paramPermutations.size());
+
+			for (size_t shard_no = 0; shard_no < shardCount; ++shard_no) {
+
+				std::ifstream in(ShardFileName(shard_no), std::ios::binary);
+				if (!in) {
+					throw std::runtime_error("shard " + std::to_string(shard_no) + " is missing");
+				}
+
+				const auto [first, last] = ShardRange(shard_no);
+				const auto results = ReadShard(in, shard_no);
+
+				for (size_t index = first; index < last; ++index) {
+					const auto& [total_orders, final_balance, metrics] = results[index - first];
+					summaries.push_back(TestSummary {
+						.totalOrders               = total_orders,
+						.finalBalance              = final_balance,
+						.params                    = StrategyType{ paramPermutations[index] }.params(),
+						.metrics                   = metrics,
+						.orderLogs                 = std::nullopt,
+						.barEndNetWorths           = std::nullopt,
+						.compressedOrderLogs       = std::nullopt,
+						.compressedBarEndNetWorths = std::nullopt
+					});
+				}
+			}
+			return summaries;
+		}
+
+		// runs what is left locally and merges
+		std::vector<TestSummary> Run(const size_t processCount = 0, const size_t maxAttempts = 3) const {
+			RunLocally(processCount, maxAttempts);
+			return Merge();
+		}
+
+	private:
+
+		using ShardResult = std::tuple<size_t, MoneyType, PerformanceMetrics>;
+
+		std::vector<ShardResult> ReadShard(std::istream& in, const size_t shardNo) const {
+
+			char magic[4] = {0};
+			std::uint32_t version = 0;
+			ResultKey key;
+			std::uint64_t shard_no = 0, first = 0, last = 0;
+
+			CheckpointReader archive(in);
+			archive(magic, version, key, shard_no, first, last);
+
+			const auto range = ShardRange(shardNo);
+			if (std::memcmp(magic, ShardFormat::MAGIC, sizeof(magic)) != 0 || version != ShardFormat::VERSION ||
+				key != sweepKey || shard_no != shardNo || first != range.first || last != range.second) {
+				throw std::runtime_error("shard " + std::to_string(shardNo) + " belongs to another sweep");
+			}
+
+			std::vector<ShardResult> results(last - first);
+			for (auto& [total_orders, final_balance, metrics] : results) {
+				std::uint64_t orders = 0;
+				archive(orders, final_balance, metrics);
+				total_orders = orders;
+			}
+			return results;
+		}
+
+		static TestOptions WithMetricsOnly(TestOptions options) noexcept {
+			options.recordingMode = RecordingMode::MetricsOnly;
+			return options;
+		}
+
+		static ResultKey MakeSweepKey(const std::vector<std::vector<ParamType>>& paramPermutations,
+									  const std::vector<Bar>& bars,
+									  const MoneyType balance,
+									  const CommissionRateType commissionRate,
+									  const TestOptions& options,
+									  const size_t shardCount) noexcept
+		{
+			std::uint64_t version = 0;
+			if constexpr (requires { StrategyType::VERSION; }) {
+				version = StrategyType::VERSION;
+			}
+			
+			Hasher hasher;
+			hasher.Add(std::string(typeid(StrategyType).name()))
+				.Add(version)
+				.Add(ResultCache::SeriesKey(bars))
+				.Add(balance)
+				.Add(commissionRate)
+				.Add(options.barsPerYear)
+				.Add(options.seed)
+				.Add(std::uint64_t(shardCount))
+				.Add(std::uint64_t(paramPermutations.size()));
+			for (const auto& params : paramPermutations) {
+				hasher.Add(params);
+			}
+			return hasher.Key();
+		}
+	};
+
+}
+
+#endif /* shard_h */
@@ -0,0 +1,363 @@
+//
+//  store.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef store_h
+#define store_h
+
+#include "types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <span>
+#include <string>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ba {
+
+	// Shared memory layout, native endianness, one loader and any number of reader processes on the same machine:
+	//   "/<name>"              control block holding the generation readers should attach to
+	//   "/<name>.<generation>" "BASB" | uint32 version | uint64 generation | uint64 ticker count
+	//                          | ticker entries sorted by name | PackedBar records of every ticker
+	// A generation is never written after it is published; a refresh publishes the next one and unlinks the old,
+	// whose pages stay valid until the last reader detaches.
+	struct SharedBarFormat
+	{
+		static constexpr char          MAGIC[4]{ 'B', 'A', 'S', 'B' };
+		static constexpr std::uint32_t VERSION{ 1 };
+		static constexpr size_t        MAX_TICKER_LENGTH{ 31 };
+
+		struct Control
+		{
+			char                       magic[4];
+			std::uint32_t              version;
+			std::atomic<std::uint64_t> generation;
+		};
+
+		struct Header
+		{
+			char          magic[4];
+			std::uint32_t version;
+			std::uint64_t generation;
+			std::uint64_t tickerCount;
+		};
+
+		struct Entry
+		{
+			char          ticker[MAX_TICKER_LENGTH + 1];
+			std::uint64_t first;
+			std::uint64_t count;
+		};
+
+		static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "generation must be shareable between processes");
+	};
+
+	// Read-only, zero copy view of the bars a loader published. Bars(ticker) can be passed to Tester::RunTest directly.
+	class SharedBarStore final
+	{
+	private:
+		std::string                             name;
+		void*                                   mapping{ nullptr };
+		size_t                                  mappingSize{ 0 };
+		std::uint64_t                           generation{ 0 };
+		std::span<const SharedBarFormat::Entry> entries;
+		const PackedBar*                        bars{ nullptr };
+
+	public:
+
+		// attaches to the latest generation, throws when nothing has been published under the name
+		explicit SharedBarStore(const std::string& name) : name(name) {
+			Attach();
+		}
+
+		SharedBarStore(SharedBarStore&& other) noexcept
+		: name(std::move(other.name))
+		, mapping(std::exchange(other.mapping, nullptr))
+		, mappingSize(std::exchange(other.mappingSize, 0))
+		, generation(std::exchange(other.generation, 0))
+		, entries(std::exchange(other.entries, { }))
+		, bars(std::exchange(other.bars, nullptr))
+		{ }
+
+		SharedBarStore(const SharedBarStore&) = delete;
+		SharedBarStore& operator=(const SharedBarStore&) = delete;
+
+		~SharedBarStore() {
+			Unmap();
+		}
+
+		std::uint64_t Generation() const noexcept {
+			return generation;
+		}
+
+		// false once the loader has published newer data
+		bool IsCurrent() const {
+			return LatestGeneration(name) == generation;
+		}
+
+		// attaches to the latest generation if it changed, spans taken before a refresh must not be used after it
+		bool Refresh() {
+			if (IsCurrent()) {
+				return false;
+			}
+			Unmap();
+			Attach();
+			return true;
+		}
+
+		std::vector<std::string> Tickers() const {
+			std::vector<std::string> tickers;
+			tickers.reserve(entries.size());
+			for (const auto& entry : entries) {
+				tickers.emplace_back(entry.ticker);
+			}
+			return tickers;
+		}
+
+		bool Contains(const std::string& ticker) const noexcept {
+			return Find(ticker) != nullptr;
+		}
+
+		std::span<const PackedBar> Bars(const std::string& ticker) const {
+			const SharedBarFormat::Entry* const entry = Find(ticker);
+			if (entry == nullptr) {
+				throw std::out_of_range("no bars for " + ticker);
+			}
+			return std::span<const PackedBar>(bars + entry->first, entry->count);
+		}
+
+		// loader side, copies the bars into a new generation and makes it the latest, returns its number
+		static std::uint64_t Publish(const std::string& name, const std::map<std::string, std::vector<Bar>>& tickerNameToBarsMap) {
+
+			size_t bar_count = 0;
+			for (const auto& [ticker_name, ticker_bars] : tickerNameToBarsMap) {
+				if (ticker_name.size() > SharedBarFormat::MAX_TICKER_LENGTH) {
+					throw std::invalid_argument("ticker name is too long: " + ticker_name);
+				}
+				bar_count += ticker_bars.size();
+			}
+
+			SharedBarFormat::Control* const control = MapControl(name);
+			const std::uint64_t previous_generation = control->generation.load(std::memory_order_acquire);
+			const std::uint64_t next_generation = previous_generation + 1;
+
+			const size_t size = BarsOffset(tickerNameToBarsMap.size()) + bar_count * sizeof(PackedBar);
+			const std::string segment_name = SegmentName(name, next_generation);
+
+			shm_unlink(segment_name.c_str());
+			const int fd = shm_open(segment_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+			if (fd < 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+				if (fd >= 0) {
+					close(fd);
+				}
+				munmap(control, sizeof(SharedBarFormat::Control));
+				throw std::runtime_error("could not create " + segment_name);
+			}
+			void* const segment = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			close(fd);
+			if (segment == MAP_FAILED) {
+				munmap(control, sizeof(SharedBarFormat::Control));
+				throw std::runtime_error("could not map " + segment_name);
+			}
+
+			char* const bytes = static_cast<char*>(segment);
+			SharedBarFormat::Header header{ };
+			std::memcpy(header.magic, SharedBarFormat::MAGIC, sizeof(header.magic));
+			header.version = SharedBarFormat::VERSION;
+			header.generation = next_generation;
+			header.tickerCount = tickerNameToBarsMap.size();
+			std::memcpy(bytes, &header, sizeof(header));
+
+			auto* const entry_array = reinterpret_cast<SharedBarFormat::Entry*>(bytes + sizeof(SharedBarFormat::Header));
+			auto* const bar_array = reinterpret_cast<PackedBar*>(bytes + BarsOffset(tickerNameToBarsMap.size()));
+
+			size_t entry_no = 0;
+			size_t first = 0;
+			for (const auto& [ticker_name, ticker_bars] : tickerNameToBarsMap) {
+				SharedBarFormat::Entry entry{ };
+				std::memcpy(entry.ticker, ticker_name.data(), ticker_name.size());
+				entry.first = first;
+				entry.count = ticker_bars.size();
+				entry_array[entry_no++] = entry;
+				for (const Bar& bar : ticker_bars) {
+					bar_array[first++] = PackedBar::FromBar(bar);
+				}
+			}
+			munmap(segment, size);
+
+			// readers that see the new generation also see its bars
+			control->generation.store(next_generation, std::memory_order_release);
+			munmap(control, sizeof(SharedBarFormat::Control));
+
+			if (previous_generation != 0) {
+				shm_unlink(SegmentName(name, previous_generation).c_str());
+			}
+			return next_generation;
+		}
+
+		// loader side, readers attached already keep their mapping
+		static void Remove(const std::string& name) {
+			const std::uint64_t latest = LatestGeneration(name);
+			if (latest != 0) {
+				shm_unlink(SegmentName(name, latest).c_str());
+			}
+			shm_unlink(ControlName(name).c_str());
+		}
+
+		// 0 when nothing has been published
+		static std::uint64_t LatestGeneration(const std::string& name) {
+
+			const int fd = shm_open(ControlName(name).c_str(), O_RDONLY, 0);
+			if (fd < 0) {
+				return 0;
+			}
+			struct stat status{ };
+			if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(SharedBarFormat::Control)) {
+				close(fd);
+				return 0;
+			}
+			void* const mapped = mmap(nullptr, sizeof(SharedBarFormat::Control), PROT_READ, MAP_SHARED, fd, 0);
+			close(fd);
+			if (mapped == MAP_FAILED) {
+				return 0;
+			}
+			const auto* const control = static_cast<const SharedBarFormat::Control*>(mapped);
+			const std::uint64_t latest = control->generation.load(std::memory_order_acquire);
+			munmap(mapped, sizeof(SharedBarFormat::Control));
+			return latest;
+		}
+
+	private:
+
+		static std::string ControlName(const std::string& name) {
+			return "/" + name;
+		}
+
+		static std::string SegmentName(const std::string& name, const std::uint64_t generation) {
+			return "/" + name + "." + std::to_string(generation);
+		}
+
+		static size_t BarsOffset(const size_t tickerCount) noexcept {
+			const size_t offset = sizeof(SharedBarFormat::Header) + tickerCount * sizeof(SharedBarFormat::Entry);
+			return (offset + alignof(PackedBar) - 1) / alignof(PackedBar) * alignof(PackedBar);
+		}
+
+		static SharedBarFormat::Control* MapControl(const std::string& name) {
+
+			const std::string control_name = ControlName(name);
+			const int fd = shm_open(control_name.c_str(), O_RDWR | O_CREAT, 0644);
+			if (fd < 0) {
+				throw std::runtime_error("could not open " + control_name);
+			}
+			struct stat status{ };
+			const bool is_new = fstat(fd, &status) == 0 && status.st_size == 0;
+			if (is_new && ftruncate(fd, sizeof(SharedBarFormat::Control)) != 0) {
+				close(fd);
+				throw std::runtime_error("could not create " + control_name);
+			}
+			void* const mapped = mmap(nullptr, sizeof(SharedBarFormat::Control), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			close(fd);
+			if (mapped == MAP_FAILED) {
+				throw std::runtime_error("could not map " + control_name);
+			}
+
+			auto* const control = static_cast<SharedBarFormat::Control*>(mapped);
+			if (is_new) {
+				// a fresh segment is zero filled, which is generation 0
+				std::memcpy(control->magic, SharedBarFormat::MAGIC, sizeof(control->magic));
+				control->version = SharedBarFormat::VERSION;
+			}
+			else if (std::memcmp(control->magic, SharedBarFormat::MAGIC, sizeof(control->magic)) != 0 ||
+					 control->version != SharedBarFormat::VERSION) {
+				munmap(mapped, sizeof(SharedBarFormat::Control));
+				throw std::runtime_error(control_name + " is not a bar store");
+			}
+			return control;
+		}
+
+		void Attach() {
+
+			// the loader may unlink a generation right after a reader looked it up, so look again
+			for (int attempt = 0; attempt < 8; ++attempt) {
+
+				const std::uint64_t latest = LatestGeneration(name);
+				if (latest == 0) {
+					throw std::runtime_error("no bars published as " + name);
+				}
+
+				const std::string segment_name = SegmentName(name, latest);
+				const int fd = shm_open(segment_name.c_str(), O_RDONLY, 0);
+				if (fd < 0) {
+					continue;
+				}
+
+				struct stat status{ };
+				if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(SharedBarFormat::Header)) {
+					close(fd);
+					throw std::runtime_error(segment_name + " is not a bar store");
+				}
+
+				mappingSize = static_cast<size_t>(status.st_size);
+				mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+				close(fd);
+				if (mapping == MAP_FAILED) {
+					mapping = nullptr;
+					throw std::runtime_error("could not map " + segment_name);
+				}
+
+				const char* const bytes = static_cast<const char*>(mapping);
+				SharedBarFormat::Header header{ };
+				std::memcpy(&header, bytes, sizeof(header));
+
+				if (std::memcmp(header.magic, SharedBarFormat::MAGIC, sizeof(header.magic)) != 0 ||
+					header.version != SharedBarFormat::VERSION || header.generation != latest ||
+					BarsOffset(header.tickerCount) > mappingSize) {
+					Unmap();
+					throw std::runtime_error(segment_name + " is not a bar store");
+				}
+
+				generation = latest;
+				entries = std::span<const SharedBarFormat::Entry>(
+					reinterpret_cast<const SharedBarFormat::Entry*>(bytes + sizeof(SharedBarFormat::Header)), header.tickerCount);
+				bars = reinterpret_cast<const PackedBar*>(bytes + BarsOffset(header.tickerCount));
+				return;
+			}
+			throw std::runtime_error("could not attach to " + name);
+		}
+
+		const SharedBarFormat::Entry* Find(const std::string& ticker) const noexcept {
+			const auto entry = std::lower_bound(entries.begin(), entries.end(), ticker, [](const SharedBarFormat::Entry& entry, const std::string& ticker) {
+				return std::strncmp(entry.ticker, ticker.c_str(), sizeof(entry.ticker)) < 0;
+			});
+			if (entry == entries.end() || std::strncmp(entry->ticker, ticker.c_str(), sizeof(entry->ticker)) != 0) {
+				return nullptr;
+			}
+			return &*entry;
+		}
+
+		void Unmap() noexcept {
+			if (mapping != nullptr) {
+				munmap(mapping, mappingSize);
+				mapping = nullptr;
+			}
+			entries = { };
+			bars = nullptr;
+		}
+	};
+
+}
+
+#endif /* store_h */
@@ -0,0 +1,269 @@
+//
+//  stream.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef stream_h
+#define stream_h
+
+#include "types.h"
+#include "utils.h"
+#include "tester.h"
+
+#include <cstdio>
+#include <cstdint>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <charconv>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ba {
+
+	// log2 buckets of nanoseconds, bucket b holds latencies in [2^(b-1), 2^b)
+	class LatencyHistogram final
+	{
+	private:
+		static constexpr size_t BUCKETS = 64;
+
+		std::array<std::uint64_t, BUCKETS> counts{ };
+		std::uint64_t count{ 0 };
+		std::uint64_t sum{ 0 };
+		std::uint64_t min{ UINT64_MAX };
+		std::uint64_t max{ 0 };
+
+	public:
+
+		void Record(const std::chrono::nanoseconds latency) noexcept {
+			const std::uint64_t ns = static_cast<std::uint64_t>(std::max<std::int64_t>(0, latency.count()));
+			counts[std::min<size_t>(BUCKETS - 1, std::bit_width(ns))]++;
+			count++;
+			sum += ns;
+			min = std::min(min, ns);
+			max = std::max(max, ns);
+		}
+
+		std::uint64_t Count() const noexcept { return count; }
+		std::chrono::nanoseconds Min() const noexcept { return std::chrono::nanoseconds(count != 0 ? min : 0); }
+		std::chrono::nanoseconds Max() const noexcept { return std::chrono::nanoseconds(max); }
+		std::chrono::nanoseconds Mean() const noexcept { return std::chrono::nanoseconds(count != 0 ? sum / count : 0); }
+		const std::array<std::uint64_t, BUCKETS>& Buckets() const noexcept { return counts; }
+
+		// upper bound of the bucket holding the q-th latency, q in [0, 1]
+		std::chrono::nanoseconds Percentile(const double q) const noexcept {
+			if (count == 0) {
+				return std::chrono::nanoseconds(0);
+			}
+			const std::uint64_t rank = std::uint64_t(BarUtils::KeepInRange(0, q, 1) * (count - 1)) + 1;
+			std::uint64_t seen = 0;
+			for (size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+				seen += counts[bucket];
+				if (seen >= rank) {
+					const std::uint64_t upper = bucket == 0 ? 0 : (std::uint64_t(1) << bucket) - 1;
+					return std::chrono::nanoseconds(std::min(upper, max));
+				}
+			}
+			return Max();
+		}
+	};
+
+	struct StreamStats
+	{
+		std::uint64_t    barCount{ 0 };
+		std::uint64_t    orderCount{ 0 };
+		std::uint64_t    skippedLineCount{ 0 };
+		LatencyHistogram parseLatency;    // line received -> bar parsed
+		LatencyHistogram dispatchLatency; // OnBarClosed + order execution
+		LatencyHistogram publishLatency;  // order handed to the publisher
+		LatencyHistogram totalLatency;    // line received -> done with the bar
+	};
+
+	// Reads "Date,Open,High,Low,Close[,...]" lines as they arrive, lines that are not bars (headers, nulls) are skipped.
+	class BarStream final
+	{
+	private:
+		std::unique_ptr<FILE, int(*)(FILE*)> file;
+		std::array<char, 256> buffer{ };
+
+		BarStream(FILE* file, int (*closer)(FILE*)) : file(file, closer) {
+			if (!file) {
+				throw std::runtime_error("bar stream could not be opened");
+			}
+		}
+
+		static int DoNotClose(FILE*) noexcept { return 0; }
+
+	public:
+
+		static BarStream FromStdin() {
+			return BarStream(stdin, &BarStream::DoNotClose);
+		}
+
+		// replays a csv file, stands in for a live feed in tests
+		static BarStream FromFile(const std::string& fileName) {
+			return BarStream(fopen(fileName.c_str(), "r"), &fclose);
+		}
+
+		// reads the standard output of a command
+		static BarStream FromCommand(const std::string& command) {
+			return BarStream(popen(command.c_str(), "r"), &pclose);
+		}
+
+		static BarStream FromUnixSocket(const std::string& socketPath) {
+
+			sockaddr_un address{ };
+			address.sun_family = AF_UNIX;
+			if (socketPath.size() >= sizeof(address.sun_path)) {
+				throw std::invalid_argument("socket path is too long");
+			}
+			std::copy(socketPath.begin(), socketPath.end(), address.sun_path);
+
+			const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+				if (fd >= 0) {
+					close(fd);
+				}
+				throw std::runtime_error("could not connect to " + socketPath);
+			}
+			return BarStream(fdopen(fd, "r"), &fclose);
+		}
+
+		// blocks until a whole line is available, returns false at the end of the stream
+		bool NextLine(std::string& line) {
+
+			line.clear();
+			while (fgets(buffer.data(), buffer.size(), file.get()) != nullptr) {
+				line += buffer.data();
+				if (!line.empty() && line.back() == '\n') {
+					line.pop_back();
+					if (!line.empty() && line.back() == '\r') {
+						line.pop_back();
+					}
+					return true;
+				}
+			}
+			return !line.empty();
+		}
+
+		static std::optional<Bar> ParseLine(const std::string& line) noexcept {
+
+			std::array<double, 4> prices = {0};
+			const char* const end = line.data() + line.size();
+			const char* cursor = std::find(line.data(), end, ',');
+
+			if (cursor == end) {
+				return std::nullopt;
+			}
+			const char* const date_end = cursor;
+
+			for (auto& price : prices) {
+				if (cursor == end || *cursor != ',') {
+					return std::nullopt;
+				}
+				const auto [next, ec] = std::from_chars(cursor + 1, end, price);
+				if (ec != std::errc{}) {
+					return std::nullopt;
+				}
+				cursor = next;
+			}
+
+			return Bar {
+				.date  = std::string(line.data(), date_end),
+				.open  = prices[0],
+				.high  = prices[1],
+				.low   = prices[2],
+				.close = prices[3]
+			};
+		}
+	};
+
+	// Drives a strategy from a live feed with the same order semantics as Tester::RunTest.
+	// Every bar is dispatched as soon as its line arrives and executed orders are published before the next read.
+	template <typename StrategyType>
+	class StreamRunner final
+	{
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		Tester::Session<StrategyType> session;
+		StreamStats stats;
+
+	public:
+
+		StreamRunner(StrategyType strategy,
+					 const MoneyType balance,
+					 const CommissionRateType commissionRate,
+					 const TestOptions& options = { .recordingMode = RecordingMode::MetricsOnly })
+		: session(std::move(strategy), balance, commissionRate, options)
+		{ }
+
+		// publisher is called as publisher(const Bar&, const OrderLog&) for every executed order
+		template <typename Publisher>
+		requires std::invocable<Publisher&, const Bar&, const OrderLog&>
+		TestSummary Run(BarStream& stream, Publisher&& publisher) {
+
+			std::string line;
+
+			while (stream.NextLine(line)) {
+
+				const auto received_at = Clock::now();
+
+				const std::optional<Bar> bar = BarStream::ParseLine(line);
+				const auto parsed_at = Clock::now();
+
+				if (!bar) {
+					stats.skippedLineCount++;
+					continue;
+				}
+
+				const std::vector<OrderLog> orders = session.BarClosed(*bar);
+				const auto dispatched_at = Clock::now();
+
+				for (const OrderLog& order : orders) {
+					publisher(*bar, order);
+				}
+				stats.orderCount += orders.size();
+				const auto published_at = Clock::now();
+
+				stats.barCount++;
+				stats.parseLatency.Record(parsed_at - received_at);
+				stats.dispatchLatency.Record(dispatched_at - parsed_at);
+				stats.totalLatency.Record(published_at - received_at);
+				if (!orders.empty()) {
+					stats.publishLatency.Record(published_at - dispatched_at);
+				}
+			}
+
+			return session.Summary();
+		}
+
+		// publishes orders as "date;Open|Close;price;positionAmount" lines
+		TestSummary Run(BarStream& stream, std::ostream& out) {
+			return Run(stream, [&out](const Bar& bar, const OrderLog& order) {
+				out << bar.date << ';' << to_string(order.orderType) << ';' << order.price << ';' << order.positionAmount << std::endl;
+			});
+		}
+
+		const StreamStats& Stats() const noexcept {
+			return stats;
+		}
+
+		const Tester::Session<StrategyType>& TestSession() const noexcept {
+			return session;
+		}
+	};
+
+}
+
+#endif /* stream_h */
@@ -0,0 +1,437 @@
+//
+//  surface.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef surface_h
+#define surface_h
+
+#include "types.h"
+#include "utils.h"
+#include "writer.h"
+#include "pareto.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ba {
+
+	// Results of a sweep over every combination of the axis params, row-major: the last axis changes fastest,
+	// which is the order of RangeUtils::Permutations.
+	struct ResultGrid
+	{
+		std::vector<std::vector<ParamType>> axes;
+		std::vector<double>                 values;
+
+		std::vector<size_t> Shape() const {
+			std::vector<size_t> shape;
+			for (const auto& axis : axes) {
+				shape.push_back(axis.size());
+			}
+			return shape;
+		}
+
+		// a cell's param on every axis
+		std::vector<ParamType> Params(size_t cell) const {
+			std::vector<ParamType> params(axes.size());
+			for (size_t axis = axes.size(); axis-- > 0; ) {
+				params[axis] = axes[axis][cell % axes[axis].size()];
+				cell /= axes[axis].size();
+			}
+			return params;
+		}
+
+		// gains[row][column] as in PipelineSummary::gains
+		static ResultGrid FromMatrix(const std::vector<ParamType>& paramsForRow,
+									 const std::vector<ParamType>& paramsForColumn,
+									 const std::vector<std::vector<double>>& gains)
+		{
+			ResultGrid grid{ .axes = { paramsForRow, paramsForColumn }, .values = { } };
+			grid.values.reserve(paramsForRow.size() * paramsForColumn.size());
+			if (gains.size() != paramsForRow.size()) {
+				throw std::invalid_argument("gain matrix does not match the row params");
+			}
+			for (const auto& row : gains) {
+				if (row.size() != paramsForColumn.size()) {
+					throw std::invalid_argument("gain matrix does not match the column params");
+				}
+				grid.values.insert(grid.values.end(), row.begin(), row.end());
+			}
+			return grid;
+		}
+
+		// a gain matrix written by RunTestOnManyStocksForGeneralOptimization with a ColumnarResultWriter:
+		// the first column holds the row params and the other columns are named by their column param
+		static ResultGrid FromColumnarResult(const ColumnarResult& result) {
+
+			if (result.columns.size() < 2) {
+				throw std::invalid_argument("result has no gain columns");
+			}
+
+			ResultGrid grid{ .axes = { result.columns[0], { } }, .values = { } };
+			for (size_t column = 1; column < result.names.size(); ++column) {
+				grid.axes[1].push_back(std::strtod(result.names[column].c_str(), nullptr));
+			}
+
+			const size_t row_count = grid.axes[0].size();
+			grid.values.reserve(row_count * grid.axes[1].size());
+			for (size_t row = 0; row < row_count; ++row) {
+				for (size_t column = 1; column < result.columns.size(); ++column) {
+					grid.values.push_back(result.columns[column][row]);
+				}
+			}
+			return grid;
+		}
+
+		// a gain matrix written by RunTestOnManyStocksForGeneralOptimization with a CsvResultWriter, whose defaults are the defaults here
+		static ResultGrid FromCsv(const std::string& fileName, const char delimiter = ';', const char decimalSeparator = ',') {
+
+			std::ifstream file(fileName);
+			if (!file) {
+				throw std::runtime_error("could not open " + fileName);
+			}
+
+			const auto parse = [&](std::string cell) {
+				std::replace(cell.begin(), cell.end(), decimalSeparator, '.');
+				double value = 0;
+				const auto [end, ec] = std::from_chars(cell.data(), cell.data() + cell.size(), value);
+				if (ec != std::errc{} || end != cell.data() + cell.size()) {
+					throw std::runtime_error(fileName + " has a cell that is not a number: " + cell);
+				}
+				return value;
+			};
+
+			ResultGrid grid{ .axes = { { }, { } }, .values = { } };
+			std::string line;
+
+			if (!std::getline(file, line)) {
+				throw std::runtime_error(fileName + " is empty");
+			}
+			const std::vector<std::string> header = StringUtils::Split(line, delimiter);
+			for (size_t column = 1; column < header.size(); ++column) {
+				if (!header[column].empty()) {
+					grid.axes[1].push_back(parse(header[column]));
+				}
+			}
+
+			while (std::getline(file, line)) {
+				if (line.empty()) {
+					continue;
+				}
+				const std::vector<std::string> cells = StringUtils::Split(line, delimiter);
+				if (cells.size() < grid.axes[1].size() + 1) {
+					throw std::runtime_error(fileName + " has a short row");
+				}
+				grid.axes[0].push_back(parse(cells[0]));
+				for (size_t column = 1; column <= grid.axes[1].size(); ++column) {
+					grid.values.push_back(parse(cells[column]));
+				}
+			}
+			return grid;
+		}
+
+		// summaries of a sweep over every combination of the params, in any order, scored as in ParetoUtils::Score
+		// every summary is placed at the cell of its params on the sorted axes; as many summaries as cells are needed,
+		// so a repeated cell, which is checked, is the only way to leave one empty
+		static ResultGrid FromSummaries(const std::vector<TestSummary>& summaries, const Objective objective) {
+
+			ResultGrid grid;
+			if (summaries.empty()) {
+				return grid;
+			}
+
+			const size_t axis_count = summaries.front().params.size();
+			grid.axes.resize(axis_count);
+			for (size_t axis = 0; axis < axis_count; ++axis) {
+				for (const TestSummary& summary : summaries) {
+					grid.axes[axis].push_back(summary.params[axis]);
+				}
+				std::sort(grid.axes[axis].begin(), grid.axes[axis].end());
+				grid.axes[axis].erase(std::unique(grid.axes[axis].begin(), grid.axes[axis].end()), grid.axes[axis].end());
+			}
+
+			size_t cell_count = 1;
+			for (const auto& axis : grid.axes) {
+				cell_count *= axis.size();
+			}
+			if (cell_count != summaries.size()) {
+				throw std::invalid_argument("summaries do not cover a full grid");
+			}
+
+			grid.values.assign(cell_count, 0);
+			std::vector<bool> filled(cell_count, false);
+
+			for (const TestSummary& summary : summaries) {
+
+				if (summary.params.size() != axis_count) {
+					throw std::invalid_argument("summaries have different param counts");
+				}
+
+				size_t cell = 0;
+				for (size_t axis = 0; axis < axis_count; ++axis) {
+					const auto& values = grid.axes[axis];
+					cell = cell * values.size() + static_cast<size_t>(std::lower_bound(values.begin(), values.end(), summary.params[axis]) - values.begin());
+				}
+				if (filled[cell]) {
+					throw std::invalid_argument("summaries repeat the cell of params " + ParamsToString(summary.params));
+				}
+				filled[cell] = true;
+				grid.values[cell] = ParetoUtils::Score(summary, objective);
+			}
+			return grid;
+		}
+
+	private:
+
+		static std::string ParamsToString(const std::vector<ParamType>& params) {
+			std::string text;
+			for (const ParamType param : params) {
+				text += (text.empty() ? "" : ", ") + std::to_string(param);
+			}
+			return text;
+		}
+	};
+
+	struct RankedCell
+	{
+		size_t                 cell{ 0 };
+		std::vector<ParamType> params;
+		double                 value{ 0 };
+		double                 mean{ 0 };
+		double                 min{ 0 };
+		double                 variance{ 0 };
+		double                 score{ 0 };
+	};
+
+	// Neighborhood statistics of every cell of a ResultGrid, the neighborhood of a cell being the box of radius[axis]
+	// cells around it on every axis, cut at the edges. Summed-area tables of the values and their squares give the
+	// mean and variance of any box from 2^axes corners; the minimum is a sliding window minimum along one axis after another.
+	// A cell on a plateau keeps a high mean and a low variance, a lone spike among bad neighbors does not.
+	class RobustnessSurface final
+	{
+	private:
+		ResultGrid          grid;
+		std::vector<size_t> shape;
+		std::vector<size_t> radius;
+		std::vector<size_t> tableStrides; // of the tables, which have one more row of zeros before every axis
+		std::vector<double> sums;
+		std::vector<double> squareSums;
+		std::vector<double> minimums;
+		double              offset{ 0 };  // subtracted before summing squares, keeps the variance accurate
+
+	public:
+
+		RobustnessSurface(ResultGrid grid, std::vector<size_t> radius)
+		: grid(std::move(grid))
+		, shape(this->grid.Shape())
+		, radius(std::move(radius))
+		{
+			if (this->radius.size() != shape.size()) {
+				throw std::invalid_argument("radius needs one value per axis");
+			}
+			if (this->grid.values.size() != CellCount()) {
+				throw std::invalid_argument("grid values do not match the axes");
+			}
+			BuildTables();
+			BuildMinimums();
+		}
+
+		size_t CellCount() const noexcept {
+			size_t count = 1;
+			for (const size_t length : shape) {
+				count *= length;
+			}
+			return count;
+		}
+
+		const ResultGrid& Grid() const noexcept {
+			return grid;
+		}
+
+		size_t NeighborCount(const size_t cell) const noexcept {
+			size_t count = 1;
+			ForEachAxisOf(cell, [&](const size_t, const size_t low, const size_t high) { count *= high - low + 1; });
+			return count;
+		}
+
+		double Mean(const size_t cell) const noexcept {
+			return BoxSum(sums, cell) / NeighborCount(cell) + offset;
+		}
+
+		double Variance(const size_t cell) const noexcept {
+			const double count = double(NeighborCount(cell));
+			const double mean = BoxSum(sums, cell) / count;
+			return std::max(0.0, BoxSum(squareSums, cell) / count - mean * mean);
+		}
+
+		double Min(const size_t cell) const noexcept {
+			return minimums[cell];
+		}
+
+		// cells by mean - penalty * standard deviation of their neighborhood, best first
+		std::vector<RankedCell> Rank(const double penalty = 1) const {
+
+			std::vector<RankedCell> ranked;
+			ranked.reserve(CellCount());
+
+			for (size_t cell = 0; cell < CellCount(); ++cell) {
+				const double mean = Mean(cell);
+				const double variance = Variance(cell);
+				ranked.push_back(RankedCell {
+					.cell     = cell,
+					.params   = grid.Params(cell),
+					.value    = grid.values[cell],
+					.mean     = mean,
+					.min      = Min(cell),
+					.variance = variance,
+					.score    = mean - penalty * std::sqrt(variance)
+				});
+			}
+
+			std::stable_sort(ranked.begin(), ranked.end(), [](const RankedCell& a, const RankedCell& b) { return a.score > b.score; });
+			return ranked;
+		}
+
+	private:
+
+		// calls fn(axis, low, high) with the inclusive bounds of the cell's neighborhood on every axis
+		template <typename Function>
+		void ForEachAxisOf(size_t cell, Function&& fn) const noexcept {
+			for (size_t axis = shape.size(); axis-- > 0; ) {
+				const size_t index = cell % shape[axis];
+				cell /= shape[axis];
+				fn(axis, index - std::min(index, radius[axis]), std::min(shape[axis] - 1, index + radius[axis]));
+			}
+		}
+
+		double BoxSum(const std::vector<double>& table, const size_t cell) const noexcept {
+
+			size_t lows[16];
+			size_t highs[16];
+			ForEachAxisOf(cell, [&](const size_t axis, const size_t low, const size_t high) {
+				lows[axis] = low * tableStrides[axis];
+				highs[axis] = (high + 1) * tableStrides[axis];
+			});
+
+			double sum = 0;
+			const size_t corner_count = size_t(1) << shape.size();
+			for (size_t corner = 0; corner < corner_count; ++corner) {
+				size_t position = 0;
+				bool negative = false;
+				for (size_t axis = 0; axis < shape.size(); ++axis) {
+					const bool is_low = (corner >> axis) & 1;
+					position += is_low ? lows[axis] : highs[axis];
+					negative ^= is_low;
+				}
+				sum += negative ? -table[position] : table[position];
+			}
+			return sum;
+		}
+
+		void BuildTables() {
+
+			if (shape.size() > 16) {
+				throw std::invalid_argument("grids have at most 16 axes");
+			}
+
+			tableStrides.assign(shape.size(), 1);
+			size_t table_size = 1;
+			for (size_t axis = shape.size(); axis-- > 0; ) {
+				tableStrides[axis] = table_size;
+				table_size *= shape[axis] + 1;
+			}
+
+			double total = 0;
+			for (const double value : grid.values) {
+				total += value;
+			}
+			offset = grid.values.empty() ? 0 : total / grid.values.size();
+
+			sums.assign(table_size, 0);
+			squareSums.assign(table_size, 0);
+
+			for (size_t cell = 0; cell < grid.values.size(); ++cell) {
+				size_t position = 0;
+				size_t rest = cell;
+				for (size_t axis = shape.size(); axis-- > 0; ) {
+					position += (rest % shape[axis] + 1) * tableStrides[axis];
+					rest /= shape[axis];
+				}
+				const double centered = grid.values[cell] - offset;
+				sums[position] = centered;
+				squareSums[position] = centered * centered;
+			}
+
+			// prefix sums along every axis in turn turn the tables into summed-area tables
+			for (size_t axis = 0; axis < shape.size(); ++axis) {
+				const size_t stride = tableStrides[axis];
+				const size_t length = shape[axis] + 1;
+				for (size_t position = 0; position < table_size; ++position) {
+					if ((position / stride) % length != 0) {
+						sums[position] += sums[position - stride];
+						squareSums[position] += squareSums[position - stride];
+					}
+				}
+			}
+		}
+
+		void BuildMinimums() {
+
+			minimums = grid.values;
+			std::vector<double> line;
+			std::vector<double> line_minimums;
+			std::deque<size_t> window;
+
+			size_t stride = 1;
+			for (size_t axis = shape.size(); axis-- > 0; ) {
+
+				const size_t length = shape[axis];
+				const size_t block = length * stride;
+				line.resize(length);
+				line_minimums.resize(length);
+
+				for (size_t first = 0; first < minimums.size(); first += block) {
+					for (size_t inner = 0; inner < stride; ++inner) {
+
+						for (size_t i = 0; i < length; ++i) {
+							line[i] = minimums[first + inner + i * stride];
+						}
+
+						// indices of increasing values, the front is the minimum of the window
+						window.clear();
+						size_t next = 0;
+						for (size_t i = 0; i < length; ++i) {
+							for (; next < length && next <= i + radius[axis]; ++next) {
+								while (!window.empty() && line[window.back()] >= line[next]) {
+									window.pop_back();
+								}
+								window.push_back(next);
+							}
+							while (window.front() + radius[axis] < i) {
+								window.pop_front();
+							}
+							line_minimums[i] = line[window.front()];
+						}
+
+						for (size_t i = 0; i < length; ++i) {
+							minimums[first + inner + i * stride] = line_minimums[i];
+						}
+					}
+				}
+				stride = block;
+			}
+		}
+	};
+
+}
+
+#endif /* surface_h */
@@ -8,11 +8,30 @@
 #ifndef tester_h
 #define tester_h
 
-#include <sstream>
+#include "types.h"
+#include "utils.h"
+#include "writer.h"
+#include "checkpoint.h"
+#include "resample.h"
+#include "mapped.h"
+#include "cache.h"
+#include "prepared.h"
+
 #include <vector>
 #include <map>
-#include <fstream>
 #include <string>
+#include <mutex>
+#include <fstream>
+#include <cstdio>
+#include <stdexcept>
+#include <typeinfo>
+#include <cmath>
+#include <concepts>
+#include <deque>
+#include <utility>
+#include <array>
+#include <span>
+#include <tuple>
 
 namespace ba {
 
@@ -29,6 +48,7 @@ namespace ba {
 			PositionType       positionType{ PositionType::Closed };
 			MoneyType          balance{ 0 };
 			CommissionRateType commissionRate{ 0 };
+			RandomService      randomService{ };
 		};
 		
 	public:
@@ -38,47 +58,522 @@ namespace ba {
 		TestSummary RunTest(StrategyType&& strategy,
 						    const std::vector<Bar>& bars,
 						    const MoneyType balance,
-						    const CommissionRateType commissionRate) noexcept
+						    const CommissionRateType commissionRate,
+						    const TestOptions& options = {}) noexcept
+		{
+			return Run(strategy, bars, ComputedPrices(bars), nullptr, balance, commissionRate, options);
+		}
+		
+		// same as above, strategies can read higher timeframes of the series through BarClosedEvent::timeframes
+		template <typename StrategyType>
+		static
+		TestSummary RunTest(StrategyType&& strategy,
+						    const TimeframeSeries& series,
+						    const MoneyType balance,
+						    const CommissionRateType commissionRate,
+						    const TestOptions& options = {}) noexcept
+		{
+			return Run(strategy, series.Base(), ComputedPrices(series.Base()), &series, balance, commissionRate, options);
+		}
+		
+		// streams through a memory-mapped series, bars passed to the strategy have a time but no date
+		template <typename StrategyType>
+		static
+		TestSummary RunTest(StrategyType&& strategy,
+						    const MappedBarSeries& series,
+						    const MoneyType balance,
+						    const CommissionRateType commissionRate,
+						    const TestOptions& options = {}) noexcept
+		{
+			return Run(strategy, series.Bars(), ComputedPrices(series.Bars()), nullptr, balance, commissionRate, options);
+		}
+		
+		// runs on a window of a series without copying it, e.g. IndexedSeries::Between, bar numbers start at the window
+		template <typename StrategyType>
+		static
+		TestSummary RunTest(StrategyType&& strategy,
+						    const std::span<const Bar> bars,
+						    const MoneyType balance,
+						    const CommissionRateType commissionRate,
+						    const TestOptions& options = {}) noexcept
+		{
+			return Run(strategy, bars, ComputedPrices(bars), nullptr, balance, commissionRate, options);
+		}
+		
+		// same as above for any packed bars, e.g. a ticker of a SharedBarStore
+		template <typename StrategyType>
+		static
+		TestSummary RunTest(StrategyType&& strategy,
+						    const std::span<const PackedBar> bars,
+						    const MoneyType balance,
+						    const CommissionRateType commissionRate,
+						    const TestOptions& options = {}) noexcept
+		{
+			return Run(strategy, bars, ComputedPrices(bars), nullptr, balance, commissionRate, options);
+		}
+		
+		// runs on the precomputed bid and ask columns of the series, the results are the same as on its bars
+		template <typename StrategyType>
+		static
+		TestSummary RunTest(StrategyType&& strategy,
+						    const PreparedSeries& series,
+						    const MoneyType balance,
+						    const CommissionRateType commissionRate,
+						    const TestOptions& options = {}) noexcept
+		{
+			return Run(strategy, series.Bars(), PreparedPrices(series), series.Timeframes(), balance, commissionRate, options);
+		}
+		
+		// Runs every strategy over the bars in one pass, each with its own state and logger, so a bar is read once
+		// for all of them. Summaries are in the order of the strategies and equal to separate RunTest calls.
+		template <typename... StrategyTypes>
+		static
+		std::array<TestSummary, sizeof...(StrategyTypes)> RunTests(const std::vector<Bar>& bars,
+																   const MoneyType balance,
+																   const CommissionRateType commissionRate,
+																   const TestOptions& options,
+																   StrategyTypes&&... strategies) noexcept
+		{
+			return RunFused(bars, ComputedPrices(bars), nullptr, balance, commissionRate, options, strategies...);
+		}
+		
+		template <typename... StrategyTypes>
+		static
+		std::array<TestSummary, sizeof...(StrategyTypes)> RunTests(const TimeframeSeries& series,
+																   const MoneyType balance,
+																   const CommissionRateType commissionRate,
+																   const TestOptions& options,
+																   StrategyTypes&&... strategies) noexcept
+		{
+			return RunFused(series.Base(), ComputedPrices(series.Base()), &series, balance, commissionRate, options, strategies...);
+		}
+		
+		template <typename... StrategyTypes>
+		static
+		std::array<TestSummary, sizeof...(StrategyTypes)> RunTests(const std::span<const Bar> bars,
+																   const MoneyType balance,
+																   const CommissionRateType commissionRate,
+																   const TestOptions& options,
+																   StrategyTypes&&... strategies) noexcept
+		{
+			return RunFused(bars, ComputedPrices(bars), nullptr, balance, commissionRate, options, strategies...);
+		}
+		
+		template <typename... StrategyTypes>
+		static
+		std::array<TestSummary, sizeof...(StrategyTypes)> RunTests(const std::span<const PackedBar> bars,
+																   const MoneyType balance,
+																   const CommissionRateType commissionRate,
+																   const TestOptions& options,
+																   StrategyTypes&&... strategies) noexcept
+		{
+			return RunFused(bars, ComputedPrices(bars), nullptr, balance, commissionRate, options, strategies...);
+		}
+		
+		template <typename... StrategyTypes>
+		static
+		std::array<TestSummary, sizeof...(StrategyTypes)> RunTests(const PreparedSeries& series,
+																   const MoneyType balance,
+																   const CommissionRateType commissionRate,
+																   const TestOptions& options,
+																   StrategyTypes&&... strategies) noexcept
+		{
+			return RunFused(series.Bars(), PreparedPrices(series), series.Timeframes(), balance, commissionRate, options, strategies...);
+		}
+		
+	private:
+		
+		static const Bar& AsBar(const Bar& bar) noexcept { return bar; }
+		static Bar AsBar(const PackedBar& bar) noexcept { return bar.ToBar(); }
+		
+		// prices computed from the bars as they are read: the bid is the close, the ask is a tick step above it,
+		// OnStart gets the open of the first bar and OnStop the close of the last bar
+		struct ComputedPrices
+		{
+			MoneyType firstTick{ 0 };
+			MoneyType lastTick{ 0 };
+			
+			template <typename BarRange>
+			explicit ComputedPrices(const BarRange& bars) noexcept
+			: firstTick(bars.empty() ? MoneyType{0} : bars.front().open)
+			, lastTick(bars.empty() ? MoneyType{0} : bars.back().close)
+			{ }
+			
+			MoneyType FirstBid() const noexcept { return firstTick; }
+			MoneyType FirstAsk() const noexcept { return firstTick + BarUtils::CalculateStep(firstTick); }
+			MoneyType LastBid() const noexcept { return lastTick; }
+			MoneyType LastAsk() const noexcept { return lastTick + BarUtils::CalculateStep(lastTick); }
+			MoneyType Bid(const Bar& bar, size_t) const noexcept { return bar.close; }
+			MoneyType Ask(const Bar& bar, size_t) const noexcept { return bar.close + BarUtils::CalculateStep(bar.close); }
+		};
+		
+		// the same prices read from the columns of a PreparedSeries
+		struct PreparedPrices
 		{
+			const PreparedSeries&  series;
+			const MoneyType* const bids;
+			const MoneyType* const asks;
+			
+			explicit PreparedPrices(const PreparedSeries& series) noexcept
+			: series(series), bids(series.Bids().data()), asks(series.Asks().data())
+			{ }
+			
+			MoneyType FirstBid() const noexcept { return series.FirstBid(); }
+			MoneyType FirstAsk() const noexcept { return series.FirstAsk(); }
+			MoneyType LastBid() const noexcept { return series.empty() ? MoneyType{0} : bids[series.size() - 1]; }
+			MoneyType LastAsk() const noexcept { return series.empty() ? BarUtils::CalculateStep(0) : asks[series.size() - 1]; }
+			MoneyType Bid(const Bar&, const size_t barNo) const noexcept { return bids[barNo]; }
+			MoneyType Ask(const Bar&, const size_t barNo) const noexcept { return asks[barNo]; }
+		};
+		
+		template <typename StrategyType, typename BarRange, typename PriceSource>
+		static
+		TestSummary Run(StrategyType& strategy,
+						const BarRange& bars,
+						const PriceSource& prices,
+						const TimeframeSeries* timeframes,
+						const MoneyType balance,
+						const CommissionRateType commissionRate,
+						const TestOptions& options) noexcept
+		{
+			TestState testState = InitialState(balance, commissionRate, options);
+			
+			OrderLogger orderLogger(balance, options.recordingMode);
+			if (options.recordingMode == RecordingMode::Full) {
+				orderLogger.barEndNetWorths.reserve(bars.size());
+			}
+			
+			Start(prices.FirstBid(), prices.FirstAsk(), strategy, testState, orderLogger);
+			
+			size_t bar_no = 0;
+			for (const auto& bar_of_range : bars) {
+				
+				const auto& bar = AsBar(bar_of_range);
+				BarClosed(bar, prices.Bid(bar, bar_no), prices.Ask(bar, bar_no), strategy, testState, orderLogger, timeframes);
+				bar_no++;
+			}
+			
+			Stop(prices.LastBid(), prices.LastAsk(), strategy, testState, orderLogger);
+			
+			return MakeSummary(strategy, orderLogger, options);
+		}
+		
+		static TestState InitialState(const MoneyType balance, const CommissionRateType commissionRate, const TestOptions& options) noexcept {
 			TestState testState;
 			testState.balance = balance;
 			testState.commissionRate = commissionRate / 100;
+			testState.randomService = RandomService(options.seed, options.runId);
+			return testState;
+		}
+		
+		template <typename StrategyType>
+		struct FusedRun
+		{
+			StrategyType& strategy;
+			TestState     testState;
+			OrderLogger   orderLogger;
+		};
+		
+		template <typename BarRange, typename PriceSource, typename... StrategyTypes>
+		static
+		std::array<TestSummary, sizeof...(StrategyTypes)> RunFused(const BarRange& bars,
+																   const PriceSource& prices,
+																   const TimeframeSeries* timeframes,
+																   const MoneyType balance,
+																   const CommissionRateType commissionRate,
+																   const TestOptions& options,
+																   StrategyTypes&... strategies) noexcept
+		{
+			const TestState testState = InitialState(balance, commissionRate, options);
+			
+			std::tuple<FusedRun<StrategyTypes>...> runs{ FusedRun<StrategyTypes>{ strategies, testState, OrderLogger(balance, options.recordingMode) }... };
+			
+			std::apply([&](auto&... run) {
+				if (options.recordingMode == RecordingMode::Full) {
+					(run.orderLogger.barEndNetWorths.reserve(bars.size()), ...);
+				}
+				
+				(Start(prices.FirstBid(), prices.FirstAsk(), run.strategy, run.testState, run.orderLogger), ...);
+				
+				size_t bar_no = 0;
+				for (const auto& bar_of_range : bars) {
+					
+					const auto& bar = AsBar(bar_of_range);
+					const MoneyType bid = prices.Bid(bar, bar_no);
+					const MoneyType ask = prices.Ask(bar, bar_no);
+					(BarClosed(bar, bid, ask, run.strategy, run.testState, run.orderLogger, timeframes), ...);
+					bar_no++;
+				}
+				
+				(Stop(prices.LastBid(), prices.LastAsk(), run.strategy, run.testState, run.orderLogger), ...);
+			}, runs);
+			
+			return std::apply([&](auto&... run) {
+				return std::array<TestSummary, sizeof...(StrategyTypes)>{ MakeSummary(run.strategy, run.orderLogger, options)... };
+			}, runs);
+		}
+		
+	public:
+		
+		// A test that is driven bar by bar and can be checkpointed before it is stopped.
+		// Summary() stops a copy of the run, so more bars can be fed afterwards.
+		template <typename StrategyType>
+		class Session final
+		{
+		private:
+			static constexpr char          MAGIC[4]{ 'B', 'A', 'C', 'P' };
+			static constexpr std::uint32_t VERSION{ 4 };
+			
+			StrategyType strategy;
+			std::vector<ParamType> strategyParams; // as the strategy reported them when the session began
+			TestOptions  options;
+			TestState    testState;
+			OrderLogger  orderLogger;
+			MoneyType    initialBalance{ 0 };
+			MoneyType    lastTick{ 0 };
+			std::string  lastBarDate;
+			bool         started{ false };
 			
-			const MoneyType firstTick = CollectionUtils::GetFirst(bars).value_or(Bar{}).open;
-			const MoneyType lastTick = CollectionUtils::GetLast(bars).value_or(Bar{}).close;
+		public:
 			
-			OrderLogger orderLogger;
+			Session(StrategyType strategy,
+					const MoneyType balance,
+					const CommissionRateType commissionRate,
+					const TestOptions& options = {}) noexcept
+			: strategy(std::move(strategy))
+			, strategyParams(this->strategy.params())
+			, options(options)
+			, orderLogger(balance, options.recordingMode)
+			, initialBalance(balance)
+			{
+				testState.balance = balance;
+				testState.commissionRate = commissionRate / 100;
+				testState.randomService = RandomService(options.seed, options.runId);
+			}
 			
-			Start(firstTick, strategy, testState, orderLogger);
+			void Start(const MoneyType firstTick) noexcept {
+				if (!started) {
+					started = true;
+					lastTick = firstTick;
+					Tester::Start(firstTick, strategy, testState, orderLogger);
+				}
+			}
+			
+			// returns the orders executed on this bar in order, including those of OnStart on the first bar
+			std::vector<OrderLog> BarClosed(const Bar& bar) {
+				std::vector<OrderLog> orders;
+				orderLogger.orderSink = &orders;
+				Start(bar.open);
+				Tester::BarClosed(bar, strategy, testState, orderLogger);
+				orderLogger.orderSink = nullptr;
+				lastTick = bar.close;
+				lastBarDate = bar.date;
+				return orders;
+			}
+			
+			// feeds the bars after the ones already seen, bars must extend the series this session was fed with
+			size_t Resume(const std::vector<Bar>& bars) {
+				
+				const size_t seen = BarCount();
+				if (bars.size() < seen || (seen != 0 && bars[seen - 1].date != lastBarDate)) {
+					throw std::invalid_argument("bars do not extend the checkpointed series");
+				}
+				
+				for (size_t i = seen; i < bars.size(); ++i) {
+					BarClosed(bars[i]);
+				}
+				return bars.size() - seen;
+			}
 			
-			for (const Bar& bar : bars) {
+			TestSummary Summary() const noexcept {
+				
+				StrategyType strategy_copy = strategy;
+				TestState test_state_copy = testState;
+				OrderLogger order_logger_copy = orderLogger;
+				
+				if (!started) {
+					Tester::Start(lastTick, strategy_copy, test_state_copy, order_logger_copy);
+				}
+				Tester::Stop(lastTick, strategy_copy, test_state_copy, order_logger_copy);
 				
-				BarClosed(bar, strategy, testState, orderLogger);
+				return MakeSummary(strategy_copy, order_logger_copy, options);
 			}
 			
-			Stop(lastTick, strategy, testState, orderLogger);
+			size_t BarCount() const noexcept {
+				return testState.barNo;
+			}
 			
-			TestSummary summary = {
-				.totalOrders     = orderLogger.orderLogs.size(),
-				.finalBalance    = CollectionUtils::GetLast(orderLogger.barEndNetWorths).value_or(MoneyType{0}),
-				.params          = strategy.params(),
-				.orderLogs       = orderLogger.orderLogs,
-				.barEndNetWorths = orderLogger.barEndNetWorths
-			};
+			MoneyType InitialBalance() const noexcept {
+				return initialBalance;
+			}
 			
-			return summary;
+			CommissionRateType CommissionRate() const noexcept {
+				return testState.commissionRate * 100;
+			}
+			
+			const TestOptions& Options() const noexcept {
+				return options;
+			}
+			
+			std::vector<ParamType> params() const noexcept {
+				return strategyParams;
+			}
+			
+			void Save(std::ostream& out) {
+				
+				CheckpointWriter writer(out);
+				
+				const std::string strategy_name = typeid(StrategyType).name();
+				out.write(MAGIC, sizeof(MAGIC));
+				writer(VERSION, strategy_name, strategyParams);
+				writer(options, testState, initialBalance, lastTick, lastBarDate, started);
+				writer(orderLogger.recordingMode, orderLogger.lastOrder, orderLogger.totalOrders, orderLogger.performance);
+				writer(orderLogger.orderLogs, orderLogger.barEndNetWorths);
+				orderLogger.compressedOrderLogs.Serialize(writer);
+				orderLogger.compressedBarEndNetWorths.Serialize(writer);
+				strategy.Serialize(writer);
+			}
+			
+			static Session Load(std::istream& in) {
+				
+				CheckpointReader reader(in);
+				
+				char magic[4] = {0};
+				std::uint32_t version = 0;
+				std::string strategy_name;
+				std::vector<ParamType> params;
+				
+				in.read(magic, sizeof(magic));
+				reader(version, strategy_name, params);
+				
+				if (!std::equal(std::begin(magic), std::end(magic), std::begin(MAGIC)) || version != VERSION || strategy_name != typeid(StrategyType).name()) {
+					throw std::runtime_error("checkpoint does not belong to this strategy");
+				}
+				
+				// the strategy's own values are restored by Serialize below, params only select the constructor
+				Session session(StrategyType{ params }, 0, 0);
+				session.strategyParams = std::move(params);
+				reader(session.options, session.testState, session.initialBalance, session.lastTick, session.lastBarDate, session.started);
+				reader(session.orderLogger.recordingMode, session.orderLogger.lastOrder, session.orderLogger.totalOrders, session.orderLogger.performance);
+				reader(session.orderLogger.orderLogs, session.orderLogger.barEndNetWorths);
+				session.orderLogger.compressedOrderLogs.Serialize(reader);
+				session.orderLogger.compressedBarEndNetWorths.Serialize(reader);
+				session.strategy.Serialize(reader);
+				
+				return session;
+			}
+			
+			void Save(const std::string& fileName) {
+				
+				const std::string temporary_file_name = fileName + ".tmp";
+				{
+					std::ofstream out(temporary_file_name, std::ios::binary | std::ios::trunc);
+					try {
+						Save(out);
+						out.close();
+					}
+					catch (...) {
+						out.close();
+						std::remove(temporary_file_name.c_str());
+						throw;
+					}
+					// a full disk shows up as a failed write or close, the previous checkpoint is kept
+					if (!out.good()) {
+						std::remove(temporary_file_name.c_str());
+						throw std::runtime_error("could not write " + fileName);
+					}
+				}
+				// replaces the previous checkpoint only after the new one is complete
+				if (std::rename(temporary_file_name.c_str(), fileName.c_str()) != 0) {
+					throw std::runtime_error("could not write " + fileName);
+				}
+			}
+			
+			static Session Load(const std::string& fileName) {
+				
+				std::ifstream in(fileName, std::ios::binary);
+				if (!in) {
+					throw std::runtime_error("could not open " + fileName);
+				}
+				return Load(in);
+			}
+		};
+		
+		// Runs the test using the checkpoint file when it matches (same strategy, params, balance, commission,
+		// recording mode and a prefix of bars), so only the appended bars are simulated. The checkpoint is updated afterwards.
+		template <typename StrategyType>
+		static
+		TestSummary RunTestIncrementally(StrategyType strategy,
+										 const std::vector<Bar>& bars,
+										 const MoneyType balance,
+										 const CommissionRateType commissionRate,
+										 const std::string& checkpointFileName,
+										 const TestOptions& options = {})
+		{
+			std::optional<Session<StrategyType>> session;
+			
+			try {
+				auto loaded = Session<StrategyType>::Load(checkpointFileName);
+				if (loaded.params() == strategy.params() &&
+					loaded.InitialBalance() == balance &&
+					std::abs(loaded.CommissionRate() - commissionRate) < 1e-12 &&
+					loaded.Options().recordingMode == options.recordingMode &&
+					loaded.Options().seed == options.seed &&
+					loaded.Options().runId == options.runId &&
+					loaded.BarCount() <= bars.size()) {
+					loaded.Resume(bars);
+					session.emplace(std::move(loaded));
+				}
+			}
+			catch (const std::exception&) {
+				session.reset();
+			}
+			
+			if (!session) {
+				session.emplace(std::move(strategy), balance, commissionRate, options);
+				session->Resume(bars);
+			}
+			
+			session->Save(checkpointFileName);
+			return session->Summary();
 		}
 		
 	private:
 		
+		template <typename StrategyType>
+		static
+		TestSummary MakeSummary(const StrategyType& strategy, OrderLogger& orderLogger, const TestOptions& options) noexcept
+		{
+			const bool recorded = options.recordingMode == RecordingMode::Full;
+			const bool compressed = options.recordingMode == RecordingMode::Compressed;
+			
+			return TestSummary {
+				.totalOrders               = orderLogger.totalOrders,
+				.finalBalance              = orderLogger.performance.LastNetWorth(),
+				.params                    = strategy.params(),
+				.metrics                   = orderLogger.performance.Metrics(options.barsPerYear),
+				.orderLogs                 = recorded ? std::optional{ std::move(orderLogger.orderLogs) } : std::nullopt,
+				.barEndNetWorths           = recorded ? std::optional{ std::move(orderLogger.barEndNetWorths) } : std::nullopt,
+				.compressedOrderLogs       = compressed ? std::optional{ std::move(orderLogger.compressedOrderLogs) } : std::nullopt,
+				.compressedBarEndNetWorths = compressed ? std::optional{ std::move(orderLogger.compressedBarEndNetWorths) } : std::nullopt
+			};
+		}
+		
 		template <typename StrategyType>
 		static
 		void Start(const MoneyType tick, StrategyType& strategy, TestState& testState, OrderLogger& orderLogger) noexcept
 		{
-			testState.bid = tick;
-			testState.ask = tick + BarUtils::CalculateStep(tick);
+			Start(tick, tick + BarUtils::CalculateStep(tick), strategy, testState, orderLogger);
+		}
+		
+		template <typename StrategyType>
+		static
+		void Start(const MoneyType bid, const MoneyType ask, StrategyType& strategy, TestState& testState, OrderLogger& orderLogger) noexcept
+		{
+			testState.bid = bid;
+			testState.ask = ask;
 			
-			StartEvent e = { testState.bid, testState.ask, testState.positionType };
+			StartEvent e = { testState.bid, testState.ask, testState.positionType, {}, testState.randomService };
 			strategy.OnStart(e);
 			
 			ExecuteTheOrder(e.orderService, testState, orderLogger);
@@ -88,10 +583,17 @@ namespace ba {
 		static
 		void Stop(const MoneyType tick, StrategyType& strategy, TestState& testState, OrderLogger& orderLogger) noexcept
 		{
-			testState.bid = tick;
-			testState.ask = tick + BarUtils::CalculateStep(tick);
+			Stop(tick, tick + BarUtils::CalculateStep(tick), strategy, testState, orderLogger);
+		}
+		
+		template <typename StrategyType>
+		static
+		void Stop(const MoneyType bid, const MoneyType ask, StrategyType& strategy, TestState& testState, OrderLogger& orderLogger) noexcept
+		{
+			testState.bid = bid;
+			testState.ask = ask;
 			
-			StopEvent e = { testState.bid, testState.ask, testState.positionType };
+			StopEvent e = { testState.bid, testState.ask, testState.positionType, {}, testState.randomService };
 			strategy.OnStop(e);
 			
 			ExecuteTheOrder(e.orderService, testState, orderLogger);
@@ -99,13 +601,20 @@ namespace ba {
 		
 		template <typename StrategyType>
 		static
-		void BarClosed(const Bar& bar, StrategyType& strategy, TestState& testState, OrderLogger& orderLogger) noexcept
+		void BarClosed(const Bar& bar, StrategyType& strategy, TestState& testState, OrderLogger& orderLogger, const TimeframeSeries* timeframes = nullptr) noexcept
 		{
 			const MoneyType tick = bar.close;
-			testState.bid = tick;
-			testState.ask = tick + BarUtils::CalculateStep(tick);
+			BarClosed(bar, tick, tick + BarUtils::CalculateStep(tick), strategy, testState, orderLogger, timeframes);
+		}
+		
+		template <typename StrategyType>
+		static
+		void BarClosed(const Bar& bar, const MoneyType bid, const MoneyType ask, StrategyType& strategy, TestState& testState, OrderLogger& orderLogger, const TimeframeSeries* timeframes) noexcept
+		{
+			testState.bid = bid;
+			testState.ask = ask;
 			
-			BarClosedEvent e = { testState.bid, testState.ask, bar, testState.positionType };
+			BarClosedEvent e = { testState.bid, testState.ask, bar, testState.positionType, {}, testState.randomService, testState.barNo, timeframes };
 			strategy.OnBarClosed(e);
 			
 			ExecuteTheOrder(e.orderService, testState, orderLogger);
@@ -172,72 +681,282 @@ namespace ba {
 			const std::vector<ParamType>& paramsForColumn,
 			const MoneyType balance,
 			const CommissionRateType commissionRate,
-			const std::string& outputFileName)
+			const std::string& outputFileName,
+			const size_t threadCount = 0)
 		{
+			if (outputFileName == "") {
+				NullResultWriter writer;
+				RunTestOnManyStocksForGeneralOptimization<StrategyType>(tickerNameToBarsMap, paramsForRow, paramsForColumn, balance, commissionRate, writer, threadCount);
+				return;
+			}
 			
-			constexpr char TAB = ';';
-			constexpr char ENDL = '\n';
+			CsvResultWriter writer(outputFileName);
+			RunTestOnManyStocksForGeneralOptimization<StrategyType>(tickerNameToBarsMap, paramsForRow, paramsForColumn, balance, commissionRate, writer, threadCount);
+		}
+		
+		// rows of the gain matrix are computed in parallel and handed to the writer in row order as soon as they are ready
+		// with a cache, cells computed by an earlier sweep are read instead of simulated
+		// every ticker is prepared once before the first row, bars PreparedSeries rejects throw before any run
+		template<typename StrategyType, typename ResultWriterType>
+		requires requires(ResultWriterType& writer, const std::vector<double>& row) { writer.WriteRow(row); }
+		static
+		void RunTestOnManyStocksForGeneralOptimization(
+			const std::map<std::string, std::vector<Bar>>& tickerNameToBarsMap,
+			const std::vector<ParamType>& paramsForRow,
+			const std::vector<ParamType>& paramsForColumn,
+			const MoneyType balance,
+			const CommissionRateType commissionRate,
+			ResultWriterType& writer,
+			const size_t threadCount = 0,
+			ResultCache* cache = nullptr)
+		{
+			std::vector<std::string> header{ "" };
+			for (auto param_for_column : paramsForColumn) {
+				header.push_back(writer.Format(param_for_column));
+			}
+			writer.WriteHeader(header);
 			
-			std::ostringstream report;
-			report.imbue(std::locale("de_DE"));
+			std::mutex pending_mutex;
+			std::map<size_t, std::vector<double>> pending_rows;
+			size_t next_row_to_write = 0;
 			
-			report << TAB;
-			for (auto param_for_row : paramsForRow) {
-				report << param_for_row << TAB;
+			const size_t ticker_count = tickerNameToBarsMap.size();
+			
+			// every cell of a ticker reads the same price columns, in the order of the map
+			std::deque<PreparedSeries> prepared_series;
+			std::vector<ResultKey> series_keys;
+			for (const auto& [ticker_name, bars] : tickerNameToBarsMap) {
+				prepared_series.emplace_back(bars);
+				if (cache != nullptr) {
+					series_keys.push_back(ResultCache::SeriesKey(bars));
+				}
 			}
-			report << ENDL;
 			
-			for (auto param_for_row : paramsForRow) {
-				report << param_for_row << TAB;
+			ParallelUtils::ForEachIndex(paramsForRow.size(), threadCount, [&](const size_t row_index) {
+				
+				const ParamType param_for_row = paramsForRow[row_index];
 				
-				for (auto param_for_column : paramsForColumn) {
+				std::vector<double> row;
+				row.reserve(paramsForColumn.size() + 1);
+				row.push_back(param_for_row);
+				
+				for (size_t column_index = 0; column_index < paramsForColumn.size(); ++column_index) {
+					
+					const ParamType param_for_column = paramsForColumn[column_index];
 					
 					MoneyType sum_of_total_balances = 0;
 					
-					for (const auto& [ticker_name, bars] : tickerNameToBarsMap) {
+					// the run id of a cell is the one RunTestUsingParamPermutations gives its params, on every ticker
+					const TestOptions options = {
+						.recordingMode = RecordingMode::MetricsOnly,
+						.runId         = Hasher().Add(std::vector<ParamType>{ param_for_row, param_for_column }).Key().low
+					};
+					
+					for (size_t ticker_no = 0; ticker_no < prepared_series.size(); ++ticker_no) {
 						
 						StrategyType strategy(param_for_row, param_for_column);
 						
-						const TestSummary summary = Tester::RunTest(strategy, bars, balance, commissionRate);
+						const TestSummary summary = cache != nullptr
+							? RunCachedTest(strategy, prepared_series[ticker_no], series_keys[ticker_no], balance, commissionRate, options, *cache)
+							: Tester::RunTest(strategy, prepared_series[ticker_no], balance, commissionRate, options);
 						sum_of_total_balances += summary.finalBalance;
-						
 					}
 					
-					const double gain = sum_of_total_balances / (balance * tickerNameToBarsMap.size());
-					report << gain << TAB;
+					const double gain = sum_of_total_balances / (balance * ticker_count);
+					row.push_back(gain);
 				}
 				
-				report << ENDL;
-			}
+				std::lock_guard lock(pending_mutex);
+				pending_rows.emplace(row_index, std::move(row));
+				
+				for (auto it = pending_rows.find(next_row_to_write); it != pending_rows.end(); it = pending_rows.find(next_row_to_write)) {
+					writer.WriteRow(it->second);
+					pending_rows.erase(it);
+					next_row_to_write++;
+				}
+			});
 			
-			if (outputFileName != "") {
-				std::ofstream of(outputFileName);
-				of << report.str();
-			}
+			// rows reach the file at the writer's own thresholds while the sweep runs
+			writer.Flush();
 		}
 		
-		template<typename StrategyType>
+		// options.runId is replaced by a hash of the params, so every cell gets its own random stream and
+		// the same cell gives the same result in any sweep
+		// bars is a std::vector<Bar>, a TimeframeSeries or a PreparedSeries shared by every run
+		// with a cache, cells computed by an earlier sweep are read instead of simulated; only metrics are cached,
+		// so a cache needs RecordingMode::MetricsOnly and other modes throw instead of silently simulating every cell
+		template<typename StrategyType, typename SeriesType>
 		static
 		std::vector<TestSummary> RunTestUsingParamPermutations(
 			const std::vector<std::vector<ParamType>>& paramPermutations,
-			const std::vector<Bar>& bars,
+			const SeriesType& bars,
 			const MoneyType balance,
-			const CommissionRateType commissionRate) noexcept
+			const CommissionRateType commissionRate,
+			const TestOptions& options = {},
+			ResultCache* cache = nullptr)
 		{
+			if (cache != nullptr && options.recordingMode != RecordingMode::MetricsOnly) {
+				throw std::invalid_argument("a cached sweep needs RecordingMode::MetricsOnly");
+			}
+			
 			std::vector<TestSummary> summaries;
 			summaries.reserve(paramPermutations.size());
 			
+			const ResultKey series_key = cache != nullptr ? ResultCache::SeriesKey(BaseBars(bars)) : ResultKey{};
+			
+			TestOptions run_options = options;
+			
 			for (const auto& params : paramPermutations) {
 				
 				StrategyType strategy {params};
 				
-				TestSummary summary = Tester::RunTest(strategy, bars, balance, commissionRate);
+				run_options.runId = Hasher().Add(params).Key().low;
+				
+				TestSummary summary = cache != nullptr
+					? RunCachedTest(strategy, bars, series_key, balance, commissionRate, run_options, *cache)
+					: Tester::RunTest(strategy, bars, balance, commissionRate, run_options);
 				
 				summaries.emplace_back(std::move(summary));
 			}
 			return summaries;
 		}
 		
+		// Same as above, but a run is skipped when its params are inside the decision region of an earlier run.
+		// A strategy reports as DecisionRegion() the open interval of every param within which each decision of
+		// its last run would have been taken the same way, e.g. the nearest threshold crossings of the price path.
+		// Runs taking the same decisions on the same bars have the same orders, so the earlier result is reused.
+		// Strategies drawing random numbers must not report a region, their decisions depend on the run id.
+		template<typename StrategyType, typename SeriesType>
+		requires requires (const StrategyType& strategy) {
+			{ strategy.DecisionRegion() } -> std::convertible_to<std::vector<std::pair<ParamType, ParamType>>>;
+		}
+		static
+		std::vector<TestSummary> RunTestUsingEquivalentParamPermutations(
+			const std::vector<std::vector<ParamType>>& paramPermutations,
+			const SeriesType& bars,
+			const MoneyType balance,
+			const CommissionRateType commissionRate,
+			const TestOptions& options = {})
+		{
+			// regions of recent representatives, grids are swept in order so neighbours are found among them
+			static constexpr size_t MAX_REPRESENTATIVES = 1024;
+			
+			struct Representative
+			{
+				std::vector<std::pair<ParamType, ParamType>> region;
+				size_t                                       summaryIndex;
+			};
+			
+			std::vector<TestSummary> summaries;
+			summaries.reserve(paramPermutations.size());
+			
+			std::deque<Representative> representatives;
+			TestOptions run_options = options;
+			
+			for (const auto& params : paramPermutations) {
+				
+				const auto representative = std::find_if(representatives.rbegin(), representatives.rend(), [&](const Representative& candidate) {
+					return IsInRegion(params, candidate.region);
+				});
+				
+				if (representative != representatives.rend()) {
+					const TestSummary& equivalent = summaries[representative->summaryIndex];
+					summaries.push_back(TestSummary {
+						.totalOrders               = equivalent.totalOrders,
+						.finalBalance              = equivalent.finalBalance,
+						.params                    = StrategyType{ params }.params(),
+						.metrics                   = equivalent.metrics,
+						.orderLogs                 = equivalent.orderLogs,
+						.barEndNetWorths           = equivalent.barEndNetWorths,
+						.compressedOrderLogs       = equivalent.compressedOrderLogs,
+						.compressedBarEndNetWorths = equivalent.compressedBarEndNetWorths
+					});
+					continue;
+				}
+				
+				StrategyType strategy {params};
+				
+				run_options.runId = Hasher().Add(params).Key().low;
+				summaries.emplace_back(Tester::RunTest(strategy, bars, balance, commissionRate, run_options));
+				
+				representatives.push_back(Representative{ strategy.DecisionRegion(), summaries.size() - 1 });
+				if (representatives.size() > MAX_REPRESENTATIVES) {
+					representatives.pop_front();
+				}
+			}
+			return summaries;
+		}
+		
+	private:
+		
+		// regions are narrowed by a relative margin, rounding of the strategy's own arithmetic near a bound
+		// must never move a param across it
+		static bool IsInRegion(const std::vector<ParamType>& params, const std::vector<std::pair<ParamType, ParamType>>& region) noexcept {
+			
+			static constexpr ParamType MARGIN = 1e-9;
+			
+			if (params.size() != region.size()) {
+				return false;
+			}
+			for (size_t i = 0; i < params.size(); ++i) {
+				const auto [low, high] = region[i];
+				const ParamType low_margin = std::isfinite(low) ? MARGIN * std::max<ParamType>(1, std::abs(low)) : 0;
+				const ParamType high_margin = std::isfinite(high) ? MARGIN * std::max<ParamType>(1, std::abs(high)) : 0;
+				if (!(params[i] > low + low_margin && params[i] < high - high_margin)) {
+					return false;
+				}
+			}
+			return true;
+		}
+		
+	public:
+		
+		// the bars under any series a test runs on
+		static const std::vector<Bar>& BaseBars(const std::vector<Bar>& bars) noexcept { return bars; }
+		static const std::vector<Bar>& BaseBars(const TimeframeSeries& series) noexcept { return series.Base(); }
+		static const std::vector<Bar>& BaseBars(const PreparedSeries& series) noexcept { return series.Bars(); }
+		
+		// only metrics are cached, runs recording order logs are always simulated
+		// seriesKey is ResultCache::SeriesKey of the bars, callers running many tests on a series compute it once
+		template<typename StrategyType, typename SeriesType>
+		static
+		TestSummary RunCachedTest(StrategyType& strategy,
+								  const SeriesType& bars,
+								  const ResultKey& seriesKey,
+								  const MoneyType balance,
+								  const CommissionRateType commissionRate,
+								  const TestOptions& options,
+								  ResultCache& cache)
+		{
+			if (options.recordingMode != RecordingMode::MetricsOnly) {
+				return Tester::RunTest(strategy, bars, balance, commissionRate, options);
+			}
+			
+			const std::vector<ParamType> params = strategy.params();
+			const ResultKey key = ResultCache::MakeKey<StrategyType>(params, seriesKey, balance, commissionRate, options);
+			
+			if (const auto cached = cache.Find(key)) {
+				return TestSummary {
+					.totalOrders               = cached->totalOrders,
+					.finalBalance              = cached->finalBalance,
+					.params                    = params,
+					.metrics                   = cached->metrics,
+					.orderLogs                 = std::nullopt,
+					.barEndNetWorths           = std::nullopt,
+					.compressedOrderLogs       = std::nullopt,
+					.compressedBarEndNetWorths = std::nullopt
+				};
+			}
+			
+			TestSummary summary = Tester::RunTest(strategy, bars, balance, commissionRate, options);
+			cache.Insert(key, CachedResult {
+				.totalOrders  = summary.totalOrders,
+				.finalBalance = summary.finalBalance,
+				.metrics      = summary.metrics
+			});
+			return summary;
+		}
+		
 	};
 
 }
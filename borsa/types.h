@@ -9,6 +9,9 @@
 #define types_h
 
 #include "enums.h"
+#include "metrics.h"
+#include "random.h"
+#include "compress.h"
 
 #include <cstdint>
 #include <vector>
@@ -23,6 +26,9 @@ namespace ba {
 	using ID32               = std::uint32_t;
 	using CommissionRateType = double;
 	using ParamType          = double;
+	using TimestampType      = std::int64_t; // seconds since 1970-01-01 00:00:00 UTC
+
+	class TimeframeSeries;
 
 	struct OrderService
 	{
@@ -34,11 +40,30 @@ namespace ba {
 
 	struct Bar
 	{
-		std::string date{ };
-		MoneyType   open{ 0 };
-		MoneyType   high{ 0 };
-		MoneyType   low{ 0 };
-		MoneyType   close{ 0 };
+		std::string   date{ };
+		MoneyType     open{ 0 };
+		MoneyType     high{ 0 };
+		MoneyType     low{ 0 };
+		MoneyType     close{ 0 };
+		TimestampType time{ 0 };
+	};
+
+	// fixed size bar record used by memory-mapped series, bars converted from it have an empty date
+	struct PackedBar
+	{
+		TimestampType time{ 0 };
+		MoneyType     open{ 0 };
+		MoneyType     high{ 0 };
+		MoneyType     low{ 0 };
+		MoneyType     close{ 0 };
+		
+		static PackedBar FromBar(const Bar& bar) noexcept {
+			return PackedBar { .time = bar.time, .open = bar.open, .high = bar.high, .low = bar.low, .close = bar.close };
+		}
+		
+		Bar ToBar() const noexcept {
+			return Bar { .date = {}, .open = open, .high = high, .low = low, .close = close, .time = time };
+		}
 	};
 
 	struct StartEvent
@@ -47,6 +72,7 @@ namespace ba {
 		const MoneyType    ask{ 0 };
 		const PositionType positionType{ PositionType::Closed };
 		OrderService       orderService{ };
+		RandomService&     randomService;
 	};
 
 	struct StopEvent
@@ -55,6 +81,7 @@ namespace ba {
 		const MoneyType    ask{ 0 };
 		const PositionType positionType{ PositionType::Closed };
 		OrderService       orderService{ };
+		RandomService&     randomService;
 	};
 
 	struct BarClosedEvent
@@ -64,6 +91,10 @@ namespace ba {
 		const Bar          bar{ };
 		const PositionType positionType{ PositionType::Closed };
 		OrderService       orderService{ };
+		RandomService&     randomService;
+		const ID32         barNo{ 0 };
+		// higher timeframes of the tested series, null unless the test runs on a TimeframeSeries
+		const TimeframeSeries* timeframes{ nullptr };
 	};
 
 	struct OrderLog
@@ -76,25 +107,59 @@ namespace ba {
 		OrderType orderType{ OrderType::None };
 	};
 
+	struct TestOptions
+	{
+		RecordingMode recordingMode{ RecordingMode::Full };
+		double        barsPerYear{ 252 };
+		std::uint64_t seed{ 0 };
+		std::uint64_t runId{ 0 };
+	};
+
 	class OrderLogger
 	{
 	public:
 		std::vector<OrderLog> orderLogs;
 		std::vector<MoneyType> barEndNetWorths;
+		CompressedOrderLogs compressedOrderLogs;
+		CompressedSeries compressedBarEndNetWorths;
+		PerformanceAccumulator performance;
+		OrderLog lastOrder{ };
+		size_t totalOrders{ 0 };
+		RecordingMode recordingMode{ RecordingMode::Full };
+		std::vector<OrderLog>* orderSink{ nullptr }; // also receives every order while set, in any recording mode
+		
+		OrderLogger(const MoneyType initialBalance = 0, const RecordingMode recordingMode = RecordingMode::Full) noexcept
+		: performance(initialBalance)
+		, recordingMode(recordingMode)
+		{ }
 		
 		inline
 		void add(const ID32 barNo, const MoneyType bid, const MoneyType balance, const MoneyType price, const ShareType positionAmount, const OrderType orderType) {
 			
 			const MoneyType net_worth = balance + bid * positionAmount;
 			
-			orderLogs.emplace_back(OrderLog {
+			lastOrder = OrderLog {
 				.barNo = barNo,
 				.netWorth = net_worth,
 				.balance = balance,
 				.price = price,
 				.positionAmount = positionAmount,
 				.orderType = orderType
-			});
+			};
+			
+			totalOrders++;
+			performance.OrderExecuted(orderType, price);
+			
+			if (orderSink != nullptr) {
+				orderSink->push_back(lastOrder);
+			}
+			
+			if (recordingMode == RecordingMode::Full) {
+				orderLogs.push_back(lastOrder);
+			}
+			else if (recordingMode == RecordingMode::Compressed) {
+				compressedOrderLogs.Append(barNo, net_worth, balance, price, positionAmount, orderType);
+			}
 		}
 		
 		inline
@@ -102,7 +167,14 @@ namespace ba {
 			
 			const MoneyType net_worth = balance + bid * positionAmount;
 			
-			barEndNetWorths.push_back(net_worth);
+			performance.BarClosed(net_worth, positionAmount != 0);
+			
+			if (recordingMode == RecordingMode::Full) {
+				barEndNetWorths.push_back(net_worth);
+			}
+			else if (recordingMode == RecordingMode::Compressed) {
+				compressedBarEndNetWorths.Append(net_worth);
+			}
 		}
 	};
 
@@ -110,10 +182,76 @@ namespace ba {
 		const size_t                          totalOrders{ 0 };
 		const MoneyType                       finalBalance{ 0 };
 		const std::vector<ParamType>          params{ };
+		const PerformanceMetrics              metrics{ };
 		std::optional<std::vector<OrderLog>>  orderLogs;
 		std::optional<std::vector<MoneyType>> barEndNetWorths;
+		std::optional<CompressedOrderLogs>    compressedOrderLogs;       // with RecordingMode::Compressed
+		std::optional<CompressedSeries>       compressedBarEndNetWorths; // with RecordingMode::Compressed
     };
 
+	inline
+	std::vector<OrderLog> Decompress(const CompressedOrderLogs& compressedOrderLogs) {
+		std::vector<OrderLog> order_logs;
+		order_logs.reserve(compressedOrderLogs.size());
+		compressedOrderLogs.ForEach([&order_logs](const ID32 barNo, const MoneyType netWorth, const MoneyType balance, const MoneyType price, const ShareType positionAmount, const OrderType orderType) {
+			order_logs.push_back(OrderLog{ barNo, netWorth, balance, price, positionAmount, orderType });
+		});
+		return order_logs;
+	}
+
+	// A summary in a checkpoint archive: uint64 total orders | final balance | params | PerformanceMetrics | RecordingMode
+	// followed by the recording of that mode.
+	template<typename WriterType>
+	void WriteSummary(WriterType& writer, TestSummary& summary) {
+
+		const RecordingMode recording_mode = summary.orderLogs ? RecordingMode::Full
+										   : summary.compressedOrderLogs ? RecordingMode::Compressed
+										   : RecordingMode::MetricsOnly;
+
+		writer(static_cast<std::uint64_t>(summary.totalOrders), summary.finalBalance, summary.params, summary.metrics, recording_mode);
+
+		if (recording_mode == RecordingMode::Full) {
+			writer(*summary.orderLogs, *summary.barEndNetWorths);
+		}
+		else if (recording_mode == RecordingMode::Compressed) {
+			summary.compressedOrderLogs->Serialize(writer);
+			summary.compressedBarEndNetWorths->Serialize(writer);
+		}
+	}
+
+	template<typename ReaderType>
+	TestSummary ReadSummary(ReaderType& reader) {
+
+		std::uint64_t total_orders = 0;
+		MoneyType final_balance = 0;
+		std::vector<ParamType> params;
+		PerformanceMetrics metrics;
+		RecordingMode recording_mode = RecordingMode::MetricsOnly;
+		reader(total_orders, final_balance, params, metrics, recording_mode);
+
+		TestSummary summary {
+			.totalOrders               = total_orders,
+			.finalBalance              = final_balance,
+			.params                    = std::move(params),
+			.metrics                   = metrics,
+			.orderLogs                 = std::nullopt,
+			.barEndNetWorths           = std::nullopt,
+			.compressedOrderLogs       = std::nullopt,
+			.compressedBarEndNetWorths = std::nullopt
+		};
+
+		if (recording_mode == RecordingMode::Full) {
+			summary.orderLogs.emplace();
+			summary.barEndNetWorths.emplace();
+			reader(*summary.orderLogs, *summary.barEndNetWorths);
+		}
+		else if (recording_mode == RecordingMode::Compressed) {
+			summary.compressedOrderLogs.emplace().Serialize(reader);
+			summary.compressedBarEndNetWorths.emplace().Serialize(reader);
+		}
+		return summary;
+	}
+
 }
 
 #endif /* types_h */
@@ -27,6 +27,11 @@
 #include <sstream>
 #include <numeric>
 #include <map>
+#include <charconv>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
 
 
 namespace ba {
@@ -73,6 +78,25 @@ namespace ba {
 			
 			return strings;
 		}
+		
+		// locale-independent number formatting (printf "%g" compatible with precision 6) into [first, last)
+		// without allocating, returns the end of the written chars or first when the number does not fit
+		static char* ToChars(const double value, char* const first, char* const last, const char decimalSeparator = '.', const int precision = 6) noexcept {
+			const auto [end, ec] = std::to_chars(first, last, value, std::chars_format::general, precision);
+			if (ec != std::errc{}) {
+				return first;
+			}
+			if (decimalSeparator != '.') {
+				std::replace(first, end, '.', decimalSeparator);
+			}
+			return end;
+		}
+		
+		// same as above as a string
+		static std::string ToChars(const double value, const char decimalSeparator = '.', const int precision = 6) {
+			std::array<char, 64> buffer;
+			return std::string(buffer.data(), ToChars(value, buffer.data(), buffer.data() + buffer.size(), decimalSeparator, precision));
+		}
 	};
 
 	struct RangeUtils {
@@ -137,12 +161,104 @@ namespace ba {
 		}
 	};
 
+	struct ParallelUtils {
+		
+		static size_t DefaultThreadCount() noexcept {
+			return std::max<size_t>(1, std::thread::hardware_concurrency());
+		}
+		
+		// calls fn(index) for every index in [0, count) on threadCount workers, indices are handed out dynamically
+		// the first exception thrown by a worker is rethrown on the calling thread
+		template<typename Function>
+		static void ForEachIndex(const size_t count, size_t threadCount, Function&& fn) {
+			
+			if (threadCount == 0) {
+				threadCount = DefaultThreadCount();
+			}
+			threadCount = std::min(threadCount, count);
+			
+			if (threadCount <= 1) {
+				for (size_t index = 0; index < count; ++index) {
+					fn(index);
+				}
+				return;
+			}
+			
+			std::atomic<size_t> next_index{ 0 };
+			std::exception_ptr first_exception;
+			std::mutex exception_mutex;
+			
+			const auto worker = [&]() {
+				while (true) {
+					const size_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+					if (index >= count) {
+						return;
+					}
+					try {
+						fn(index);
+					}
+					catch (...) {
+						std::lock_guard lock(exception_mutex);
+						if (!first_exception) {
+							first_exception = std::current_exception();
+						}
+						next_index.store(count, std::memory_order_relaxed);
+					}
+				}
+			};
+			
+			std::vector<std::thread> workers;
+			workers.reserve(threadCount - 1);
+			for (size_t i = 1; i < threadCount; ++i) {
+				workers.emplace_back(worker);
+			}
+			worker();
+			for (auto& thread : workers) {
+				thread.join();
+			}
+			
+			if (first_exception) {
+				std::rethrow_exception(first_exception);
+			}
+		}
+	};
+
 	struct TimeUtils {
 		
 		static time_t Epoch() {
 			return time(NULL);
 		}
 		
+		// days since 1970-01-01 of a proleptic gregorian date, independent of the local time zone
+		static constexpr std::int64_t DaysFromCivil(int year, const unsigned month, const unsigned day) noexcept {
+			year -= month <= 2;
+			const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+			const unsigned year_of_era = static_cast<unsigned>(year - era * 400);
+			const unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+			const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+			return era * 146097 + static_cast<std::int64_t>(day_of_era) - 719468;
+		}
+		
+		struct CivilDate
+		{
+			int      year{ 1970 };
+			unsigned month{ 1 };
+			unsigned day{ 1 };
+		};
+		
+		// inverse of DaysFromCivil
+		static constexpr CivilDate CivilFromDays(std::int64_t days) noexcept {
+			days += 719468;
+			const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+			const unsigned day_of_era = static_cast<unsigned>(days - era * 146097);
+			const unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+			const unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+			const unsigned month_index = (5 * day_of_year + 2) / 153;
+			const unsigned day = day_of_year - (153 * month_index + 2) / 5 + 1;
+			const unsigned month = month_index < 10 ? month_index + 3 : month_index - 9;
+			return CivilDate{ static_cast<int>(year_of_era + era * 400 + (month <= 2)), month, day };
+		}
+		
 		static std::string DateStringFromEpoch(const time_t epoch) noexcept {
 			std::ostringstream ss;
 			const struct tm* date_time = gmtime(&epoch);
@@ -150,16 +266,103 @@ namespace ba {
 			return ss.str();
 		}
 		
-		static time_t EpochFromDateString(const std::string& dateString) noexcept {
-			assert(dateString.size() == 10);
-			struct tm date_time = {0};
-			date_time.tm_year = std::stoi(std::string{std::begin(dateString)  , std::begin(dateString)+4}) - 1900;
-			date_time.tm_mon  = std::stoi(std::string{std::begin(dateString)+5, std::begin(dateString)+7}) - 1;
-			date_time.tm_mday = std::stoi(std::string{std::begin(dateString)+8, std::end(dateString)    });
-			return mktime(&date_time);
+		// UTC seconds of a date or date and time TimestampFromString reads, e.g. "2024-01-02" or "2024-01-02 09:30"
+		static time_t EpochFromDateString(const std::string& dateString) {
+			const auto timestamp = TimestampFromString(dateString);
+			if (!timestamp) {
+				throw std::invalid_argument("not a date: \"" + dateString + "\"");
+			}
+			return static_cast<time_t>(*timestamp);
+		}
+		
+		// writes "YYYY-MM-DD" of a UTC timestamp into 10 chars without allocating
+		static constexpr void FormatDate(const std::int64_t timestamp, char* const out) noexcept {
+			const std::int64_t days = timestamp / 86400 - (timestamp % 86400 < 0);
+			const CivilDate date = CivilFromDays(days);
+			const auto put = [out](size_t position, unsigned value, size_t length) {
+				for (; length > 0; --length, value /= 10) {
+					out[position + length - 1] = static_cast<char>('0' + value % 10);
+				}
+			};
+			put(0, static_cast<unsigned>(date.year), 4);
+			out[4] = '-';
+			put(5, date.month, 2);
+			out[7] = '-';
+			put(8, date.day, 2);
+		}
+		
+		// "YYYY-MM-DD", optionally followed by [ T]HH:MM[:SS] and a Z or (+|-)HH:MM offset, as UTC seconds
+		// returns nullopt unless the whole text has this form with every field in range
+		static std::optional<std::int64_t> TimestampFromString(const std::string& text) noexcept {
+			
+			// exactly length digits below limit, a sign or a space makes the field malformed
+			const auto number = [&](const size_t position, const size_t length, const int limit) -> std::optional<int> {
+				if (position + length > text.size()) {
+					return std::nullopt;
+				}
+				int value = 0;
+				for (size_t i = position; i < position + length; ++i) {
+					if (text[i] < '0' || text[i] > '9') {
+						return std::nullopt;
+					}
+					value = value * 10 + (text[i] - '0');
+				}
+				return value < limit ? std::optional{ value } : std::nullopt;
+			};
+			const auto is = [&](const size_t position, const char c) {
+				return position < text.size() && text[position] == c;
+			};
+			
+			const auto year = number(0, 4, 10000), month = number(5, 2, 13), day = number(8, 2, 32);
+			if (!year || !month || !day || !is(4, '-') || !is(7, '-') || *month == 0 || *day == 0) {
+				return std::nullopt;
+			}
+			
+			// a day past the end of its month comes back as a day of the next month
+			const std::int64_t days = DaysFromCivil(*year, *month, *day);
+			const CivilDate date = CivilFromDays(days);
+			if (date.month != static_cast<unsigned>(*month) || date.day != static_cast<unsigned>(*day)) {
+				return std::nullopt;
+			}
+			
+			std::int64_t timestamp = days * 86400;
+			if (text.size() == 10) {
+				return timestamp;
+			}
+			
+			const auto hour = number(11, 2, 24), minute = number(14, 2, 60);
+			if (!(is(10, ' ') || is(10, 'T')) || !hour || !is(13, ':') || !minute) {
+				return std::nullopt;
+			}
+			timestamp += *hour * 3600 + *minute * 60;
+			
+			size_t position = 16;
+			if (is(position, ':')) {
+				const auto second = number(17, 2, 60);
+				if (!second) {
+					return std::nullopt;
+				}
+				timestamp += *second;
+				position = 19;
+			}
+			
+			if (is(position, 'Z')) {
+				position++;
+			}
+			else if (is(position, '+') || is(position, '-')) {
+				const int sign = text[position] == '+' ? 1 : -1;
+				const auto offset_hour = number(position + 1, 2, 24), offset_minute = number(position + 4, 2, 60);
+				if (!offset_hour || !is(position + 3, ':') || !offset_minute) {
+					return std::nullopt;
+				}
+				timestamp -= sign * (*offset_hour * 3600 + *offset_minute * 60);
+				position += 6;
+			}
+			
+			return position == text.size() ? std::optional{ timestamp } : std::nullopt;
 		}
 		
-		static std::string EpochStringFromDateString(const std::string& dateString) noexcept {
+		static std::string EpochStringFromDateString(const std::string& dateString) {
 			const time_t epoch = EpochFromDateString(dateString);
 			return std::to_string(epoch);
 		}
@@ -197,8 +400,8 @@ namespace ba {
 		
 	private:
 		
-		static std::string BuildApiUrl(const std::string& ticker, const std::string& period1, const std::string& period2) noexcept {
-			return "https://query1.finance.yahoo.com/v7/finance/download/" + ticker + "?period1=" + period1 + "&period2=" + period2 + "&interval=1d&events=history&includeAdjustedClose=true";
+		static std::string BuildApiUrl(const std::string& ticker, const std::string& period1, const std::string& period2, const std::string& interval) noexcept {
+			return "https://query1.finance.yahoo.com/v7/finance/download/" + ticker + "?period1=" + period1 + "&period2=" + period2 + "&interval=" + interval + "&events=history&includeAdjustedClose=true";
 		}
 		
 		static std::string DownloadBarData(const std::string& url) {
@@ -220,7 +423,8 @@ namespace ba {
 			
 			const auto lines = StringUtils::Split(data, '\n');
 			
-			if (lines.size() < 1 || lines[0] != "Date,Open,High,Low,Close,Adj Close,Volume") {
+			// intraday intervals are served with a "Datetime" column
+			if (lines.size() < 1 || (lines[0] != "Date,Open,High,Low,Close,Adj Close,Volume" && lines[0] != "Datetime,Open,High,Low,Close,Adj Close,Volume")) {
 				return {};
 			}
 			
@@ -238,7 +442,8 @@ namespace ba {
 					.open  = std::stof(cells[1]),
 					.high  = std::stof(cells[2]),
 					.low   = std::stof(cells[3]),
-					.close = std::stof(cells[4])
+					.close = std::stof(cells[4]),
+					.time  = TimeUtils::TimestampFromString(cells[0]).value_or(0)
 				});
 				
 			});
@@ -248,13 +453,15 @@ namespace ba {
 		
 	public:
 		
+		// interval is one of Yahoo's intervals: 1m, 2m, 5m, 15m, 30m, 60m, 90m, 1h, 1d, 5d, 1wk, 1mo, 3mo
 		static auto GetBars(const std::string& ticker_name,
 							const std::string& first_date,
-							const std::string& last_date)
+							const std::string& last_date,
+							const std::string& interval = "1d")
 		{
 			const auto period1 = TimeUtils::EpochStringFromDateString(first_date);
 			const auto period2 = TimeUtils::EpochStringFromDateString(last_date);
-			const auto url = DataUtils::BuildApiUrl(ticker_name, period1, period2);
+			const auto url = DataUtils::BuildApiUrl(ticker_name, period1, period2, interval);
 			const auto data = DataUtils::DownloadBarData(url);
 			auto bars = DataUtils::BarDataToBars(data);
 			return bars;
@@ -262,11 +469,12 @@ namespace ba {
 		
 		static auto GetBars(const std::vector<std::string>& ticker_names,
 							const std::string& first_date,
-							const std::string& last_date)
+							const std::string& last_date,
+							const std::string& interval = "1d")
 		{
 			std::map<std::string, std::vector<Bar>> ticker_name_to_bars_map;
 			for (auto&& ticker_name : ticker_names) {
-				auto bars = GetBars(ticker_name, first_date, last_date);
+				auto bars = GetBars(ticker_name, first_date, last_date, interval);
 				ticker_name_to_bars_map.insert(std::make_pair(ticker_name, std::move(bars)));
 			}
 			return ticker_name_to_bars_map;
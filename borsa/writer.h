@@ -0,0 +1,299 @@
+//
+//  writer.h
+//  BorsaAnaliz
+//
+//  Created by Samet Pilav on 19.10.2026.
+//
+
+#ifndef writer_h
+#define writer_h
+
+#include "utils.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+namespace ba {
+
+	// Result writers take rows of numbers from many worker threads and push them to disk incrementally,
+	// so a long sweep neither keeps its whole report in memory nor loses finished rows when it dies.
+	//
+	// A result writer provides:
+	//   std::string Format(double) const
+	//   void WriteHeader(const std::vector<std::string>& names)
+	//   void WriteRow(const std::vector<double>& values)
+	//   void Flush()
+
+	class CsvResultWriter final
+	{
+	private:
+		std::ofstream file;
+		std::string buffer;
+		std::mutex mutex;
+		const char delimiter;
+		const char decimalSeparator;
+		const int precision;
+		const size_t flushThreshold;
+
+	public:
+
+		// defaults keep the old report layout: ';' separated cells with decimal comma
+		CsvResultWriter(const std::string& fileName,
+						const char delimiter = ';',
+						const char decimalSeparator = ',',
+						const int precision = 6,
+						const size_t flushThreshold = 64 * 1024)
+		: file(fileName, std::ios::binary | std::ios::trunc)
+		, delimiter(delimiter)
+		, decimalSeparator(decimalSeparator)
+		, precision(precision)
+		, flushThreshold(flushThreshold)
+		{
+			if (!file) {
+				throw std::runtime_error("could not open " + fileName);
+			}
+			buffer.reserve(flushThreshold);
+		}
+
+		CsvResultWriter(const CsvResultWriter&) = delete;
+		CsvResultWriter& operator=(const CsvResultWriter&) = delete;
+
+		~CsvResultWriter() {
+			Flush();
+		}
+
+		std::string Format(const double value) const {
+			return StringUtils::ToChars(value, decimalSeparator, precision);
+		}
+
+		void WriteHeader(const std::vector<std::string>& names) {
+
+			std::string line;
+			for (const auto& name : names) {
+				line += name;
+				line += delimiter;
+			}
+			line += '\n';
+
+			Append(line);
+		}
+
+		void WriteRow(const std::vector<double>& values) {
+
+			std::string line;
+			line.reserve(values.size() * 12);
+			std::array<char, 64> cell;
+			for (const auto value : values) {
+				line.append(cell.data(), StringUtils::ToChars(value, cell.data(), cell.data() + cell.size(), decimalSeparator, precision));
+				line += delimiter;
+			}
+			line += '\n';
+
+			Append(line);
+		}
+
+		void Flush() {
+			std::lock_guard lock(mutex);
+			FlushUnlocked();
+		}
+
+	private:
+
+		void Append(const std::string& line) {
+			std::lock_guard lock(mutex);
+			buffer += line;
+			if (buffer.size() >= flushThreshold) {
+				FlushUnlocked();
+			}
+		}
+
+		void FlushUnlocked() {
+			if (!buffer.empty()) {
+				file.write(buffer.data(), buffer.size());
+				buffer.clear();
+			}
+			file.flush();
+		}
+	};
+
+	// Compact binary layout, native endianness:
+	//   "BACR" | uint32 version | uint32 columnCount | columnCount × (uint32 length, name bytes)
+	//   followed by blocks of: uint32 rowCount | columnCount × rowCount doubles, column after column
+	// Every block is self-contained, a truncated file loses only its unfinished last block.
+	class ColumnarResultWriter final
+	{
+	public:
+		static constexpr char          MAGIC[4]{ 'B', 'A', 'C', 'R' };
+		static constexpr std::uint32_t VERSION{ 1 };
+
+	private:
+		std::ofstream file;
+		std::vector<std::vector<double>> columns;
+		std::mutex mutex;
+		const size_t blockRows;
+
+	public:
+
+		ColumnarResultWriter(const std::string& fileName, const size_t blockRows = 4096)
+		: file(fileName, std::ios::binary | std::ios::trunc)
+		, blockRows(std::max<size_t>(1, blockRows))
+		{
+			if (!file) {
+				throw std::runtime_error("could not open " + fileName);
+			}
+		}
+
+		ColumnarResultWriter(const ColumnarResultWriter&) = delete;
+		ColumnarResultWriter& operator=(const ColumnarResultWriter&) = delete;
+
+		~ColumnarResultWriter() {
+			Flush();
+		}
+
+		std::string Format(const double value) const {
+			return StringUtils::ToChars(value);
+		}
+
+		void WriteHeader(const std::vector<std::string>& names) {
+
+			std::lock_guard lock(mutex);
+
+			if (!columns.empty()) {
+				throw std::logic_error("header is already written");
+			}
+
+			file.write(MAGIC, sizeof(MAGIC));
+			WritePod(VERSION);
+			WritePod(static_cast<std::uint32_t>(names.size()));
+			for (const auto& name : names) {
+				WritePod(static_cast<std::uint32_t>(name.size()));
+				file.write(name.data(), name.size());
+			}
+			file.flush();
+
+			columns.resize(names.size());
+			for (auto& column : columns) {
+				column.reserve(blockRows);
+			}
+		}
+
+		void WriteRow(const std::vector<double>& values) {
+
+			std::lock_guard lock(mutex);
+
+			if (values.size() != columns.size()) {
+				throw std::invalid_argument("row does not match the header");
+			}
+
+			for (size_t i = 0; i < values.size(); ++i) {
+				columns[i].push_back(values[i]);
+			}
+			if (!columns.empty() && columns.front().size() >= blockRows) {
+				WriteBlockUnlocked();
+			}
+		}
+
+		void Flush() {
+			std::lock_guard lock(mutex);
+			WriteBlockUnlocked();
+		}
+
+	private:
+
+		template<typename T>
+		void WritePod(const T& value) {
+			file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		void WriteBlockUnlocked() {
+
+			const size_t row_count = columns.empty() ? 0 : columns.front().size();
+			if (row_count != 0) {
+				WritePod(static_cast<std::uint32_t>(row_count));
+				for (auto& column : columns) {
+					file.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(double));
+					column.clear();
+				}
+			}
+			file.flush();
+		}
+	};
+
+	struct ColumnarResult
+	{
+		std::vector<std::string>         names;
+		std::vector<std::vector<double>> columns;
+	};
+
+	struct ColumnarResultReader
+	{
+		// reads every complete block, a partially written trailing block is ignored
+		static ColumnarResult Read(const std::string& fileName) {
+
+			std::ifstream file(fileName, std::ios::binary);
+
+			char magic[4] = {0};
+			std::uint32_t version = 0;
+			std::uint32_t column_count = 0;
+
+			file.read(magic, sizeof(magic));
+			ReadPod(file, version);
+			ReadPod(file, column_count);
+
+			if (!file || !std::equal(std::begin(magic), std::end(magic), std::begin(ColumnarResultWriter::MAGIC)) || version != ColumnarResultWriter::VERSION) {
+				throw std::runtime_error(fileName + " is not a columnar result file");
+			}
+
+			ColumnarResult result;
+			result.columns.resize(column_count);
+
+			for (std::uint32_t i = 0; i < column_count; ++i) {
+				std::uint32_t length = 0;
+				ReadPod(file, length);
+				std::string name(length, '\0');
+				file.read(name.data(), length);
+				result.names.push_back(std::move(name));
+			}
+
+			std::vector<double> block;
+			std::uint32_t row_count = 0;
+
+			while (ReadPod(file, row_count)) {
+
+				block.resize(size_t(row_count) * column_count);
+				if (!file.read(reinterpret_cast<char*>(block.data()), block.size() * sizeof(double))) {
+					break;
+				}
+				for (std::uint32_t i = 0; i < column_count; ++i) {
+					auto first = block.begin() + size_t(i) * row_count;
+					result.columns[i].insert(result.columns[i].end(), first, first + row_count);
+				}
+			}
+
+			return result;
+		}
+
+	private:
+
+		template<typename T>
+		static bool ReadPod(std::ifstream& file, T& value) {
+			return bool(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+		}
+	};
+
+	struct NullResultWriter
+	{
+		std::string Format(const double) const noexcept { return {}; }
+		void WriteHeader(const std::vector<std::string>&) noexcept { }
+		void WriteRow(const std::vector<double>&) noexcept { }
+		void Flush() noexcept { }
+	};
+
+}
+
+#endif /* writer_h */